@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Journal.h"
+#include "Transaction.h"
+
+/**
+ * @brief Pieces shared by the benchmarks: a synthetic history served from memory, a stopwatch and
+ * a check that also holds in release builds.
+ *
+ * The benchmarks run the production code against readers with the same signatures as the
+ * Firestore ones, so they measure the component and not the network. Run without arguments, a
+ * benchmark uses a small data set and checks its results; that is what ctest runs.
+ */
+namespace bench {
+
+#define BENCH_CHECK(condition)                                                                  \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                       \
+        }                                                                                       \
+    } while (0)
+
+    class Stopwatch {
+    public:
+        double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(); }
+
+    private:
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    };
+
+    /**
+     * @brief Transactions 1..count spread round-robin over `accounts` accounts, each carrying its
+     * running balance.
+     *
+     * Amounts and dates are derived from the ID, so any page can be produced without storing the
+     * rows. Dates are spread over one year and do not follow ID order, like imported history.
+     */
+    class History {
+    public:
+        History(int accounts, int count) : accounts(accounts), count(count), balanceAfter(static_cast<std::size_t>(count) + 1), balances(accounts, 0) {
+            for (int id = 1; id <= count; id++) {
+                balances[accountOf(id)] += cents(id);
+                balanceAfter[id] = balances[accountOf(id)];
+            }
+        }
+
+        int accountCount() const { return accounts; }
+        int size() const { return count; }
+        int accountOf(int id) const { return id % accounts; }
+
+        static int64_t cents(int id) { return static_cast<int64_t>(id) * 7919 % 20000 - 5000; }
+        static int month(int id) { return 1 + static_cast<int>(static_cast<int64_t>(id) * 7 % 12); }
+
+        static std::string date(int id) {
+            char text[16];
+            std::snprintf(text, sizeof(text), "2025-%02d-%02d", month(id), 1 + id % 28);
+            return text;
+        }
+
+        Transaction at(int id) const {
+            return Transaction(id, accountOf(id), cents(id) >= 0 ? "deposit" : "withdrawal", Journal::fromCents(cents(id)), date(id),
+                               Journal::fromCents(balanceAfter[id]));
+        }
+
+        int64_t balanceCents(int accountID) const { return balances[accountID]; }
+
+        /**
+         * @brief A page of one account's transactions, like Transaction::getTransactionsPage.
+         */
+        std::vector<Transaction> accountPage(int accountID, int after, std::size_t limit) const {
+            std::vector<Transaction> page;
+            page.reserve(limit);
+            int64_t id = std::max(after, 0) + 1;
+            id += ((accountID - id % accounts) % accounts + accounts) % accounts;
+            for (; id <= count && page.size() < limit; id += accounts) {
+                page.push_back(at(static_cast<int>(id)));
+            }
+            return page;
+        }
+
+        /**
+         * @brief A page of every account's transactions, like Transaction::getAllTransactionsPage.
+         */
+        std::vector<Transaction> scanPage(int after, std::size_t limit) const {
+            std::vector<Transaction> page;
+            page.reserve(limit);
+            for (int64_t id = std::max(after, 0) + 1; id <= count && page.size() < limit; id++) {
+                page.push_back(at(static_cast<int>(id)));
+            }
+            return page;
+        }
+
+    private:
+        const int accounts;
+        const int count;
+        std::vector<int64_t> balanceAfter; // indexed by transaction ID
+        std::vector<int64_t> balances;     // the final balance of every account
+    };
+
+    inline long argument(int argc, char** argv, int index, long fallback) {
+        return argc > index ? std::atol(argv[index]) : fallback;
+    }
+}
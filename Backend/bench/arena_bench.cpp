@@ -0,0 +1,206 @@
+// Serves the same settle-style route with and without the request arena over a loopback
+// connection and counts the malloc calls each request makes.
+// Usage: arena_bench [requests] [settlements per request] [port]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+#include "JsonIndex.h"
+#include "JsonWriter.h"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace {
+    std::atomic<std::size_t> allocations{ 0 };
+}
+
+// Every operator new in the process is counted; the client below does not allocate once warmed up,
+// so what the counter moves by per request is the server's share.
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // GCC pairs inlined new expressions with free()
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+    using boost::asio::ip::tcp;
+
+    const crow::header_block jsonHeaders{ { "Content-Type", "application/json" } };
+
+    // the reply of POST /api/holds/settle, with every settlement posted
+    template <typename Writer>
+    void writePostings(Writer& writer, int accountID, const SettleRequest& request) {
+        writer.beginObject();
+        writer.key("postings");
+        writer.beginArray();
+        for (const auto& settlement : request.settlements) {
+            writer.beginObject();
+            writer.key("holdID");
+            writer.value(settlement.holdID);
+            writer.key("accountID");
+            writer.value(accountID);
+            writer.key("settled");
+            writer.value(settlement.amount);
+            writer.key("balanceAfter");
+            writer.value(1000.0 - settlement.amount);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+
+    /**
+     * @brief Sends one request on a kept-alive connection and reads its whole response.
+     * @return The body, or an empty view if the connection failed.
+     */
+    std::string_view roundTrip(tcp::socket& socket, const std::string& request, std::vector<char>& buffer) {
+        boost::system::error_code ec;
+        boost::asio::write(socket, boost::asio::buffer(request), ec);
+        std::size_t received = 0;
+        std::size_t bodyAt = 0;
+        std::size_t length = 0;
+        while (!ec) {
+            received += socket.read_some(boost::asio::buffer(buffer.data() + received, buffer.size() - received), ec);
+            const std::string_view text(buffer.data(), received);
+            if (bodyAt == 0) {
+                const std::size_t end = text.find("\r\n\r\n");
+                const std::size_t tag = text.find("Content-Length: ");
+                if (end == std::string_view::npos || tag == std::string_view::npos) {
+                    continue;
+                }
+                bodyAt = end + 4;
+                length = std::strtoul(buffer.data() + tag + 16, nullptr, 10);
+            }
+            if (received >= bodyAt + length) {
+                return text.substr(bodyAt, length);
+            }
+        }
+        return {};
+    }
+
+    struct RunStats {
+        double mallocsPerRequest;
+        double p50Micros;
+        double p99Micros;
+    };
+
+    RunStats run(tcp::socket& socket, const std::string& request, int requests, std::size_t settlements, std::vector<char>& buffer) {
+        std::vector<double> micros(static_cast<std::size_t>(requests));
+        for (int i = 0; i < 100; i++) {
+            roundTrip(socket, request, buffer); // warm the pools and the thread-local buffers
+        }
+        const std::size_t before = allocations.load();
+        for (int i = 0; i < requests; i++) {
+            const bench::Stopwatch stopwatch;
+            const std::string_view body = roundTrip(socket, request, buffer);
+            micros[i] = stopwatch.seconds() * 1e6;
+            std::size_t postings = 0;
+            for (std::size_t at = body.find("\"holdID\""); at != std::string_view::npos; at = body.find("\"holdID\"", at + 1)) {
+                postings++;
+            }
+            BENCH_CHECK(postings == settlements);
+        }
+        const std::size_t after = allocations.load();
+        std::sort(micros.begin(), micros.end());
+        return RunStats{ static_cast<double>(after - before) / requests, micros[micros.size() / 2], micros[micros.size() * 99 / 100] };
+    }
+}
+
+int main(int argc, char** argv) {
+    const int requests = static_cast<int>(bench::argument(argc, argv, 1, 2000));
+    const std::size_t settlements = static_cast<std::size_t>(bench::argument(argc, argv, 2, 12));
+    const unsigned short port = static_cast<unsigned short>(bench::argument(argc, argv, 3, 18427));
+
+    crow::SimpleApp app;
+    app.loglevel(crow::LogLevel::Warning);
+
+    // what a route did before the arena: a per-thread index and a body grown on the heap
+    CROW_ROUTE(app, "/plain/<int>").methods("POST"_method)
+    ([](const crow::request& req, int accountID) {
+        SettleRequest request;
+        if (!SettleRequest::parse(req.body, request)) {
+            return crow::response(400);
+        }
+        crow::response res;
+        JsonWriter writer(res.body);
+        writePostings(writer, accountID, request);
+        res.add_header_block(jsonHeaders);
+        return res;
+    });
+
+    // the same route with its index and body in the request's arena
+    CROW_ROUTE(app, "/arena/<int>").methods("POST"_method)
+    ([](const crow::request& req, int accountID) {
+        SettleRequest request;
+        if (!req.arena || !SettleRequest::parse(req.body, request, req.arena)) {
+            return crow::response(400);
+        }
+        std::pmr::string& out = req.arena->make_string();
+        ArenaJsonWriter writer(out);
+        writePostings(writer, accountID, request);
+        crow::response res;
+        res.set_body_view(out);
+        res.add_header_block(jsonHeaders);
+        return res;
+    });
+
+    std::thread server([&app, port] { app.bindaddr("127.0.0.1").port(port).concurrency(1).run(); });
+
+    boost::asio::io_service io;
+    tcp::socket socket(io);
+    boost::system::error_code ec = boost::asio::error::not_connected;
+    for (int attempt = 0; attempt < 500 && ec; attempt++) {
+        socket.close();
+        socket.connect(tcp::endpoint(boost::asio::ip::address_v4::loopback(), port), ec);
+        if (ec) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    BENCH_CHECK(!ec);
+
+    std::string body = "{\"settlements\":[";
+    for (std::size_t i = 0; i < settlements; i++) {
+        body += (i ? ",{\"holdID\":\"" : "{\"holdID\":\"") + std::to_string(100000 + i) + "\",\"amount\":" + std::to_string(10 + i) + ".25}";
+    }
+    body += "]}";
+    const auto post = [&body](const char* path) {
+        return std::string("POST ") + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\n\r\n" + body;
+    };
+    const std::string plainRequest = post("/plain/7");
+    const std::string arenaRequest = post("/arena/7");
+    std::vector<char> buffer(1 << 16);
+
+    const RunStats plain = run(socket, plainRequest, requests, settlements, buffer);
+    const std::size_t heapBlocks = crow::detail::get_request_arena_stats().heap_blocks.load();
+    const RunStats arena = run(socket, arenaRequest, requests, settlements, buffer);
+
+    // the arena route's temporaries fit in the pooled block, and it saves every body and index allocation
+    BENCH_CHECK(crow::detail::get_request_arena_stats().heap_blocks.load() == heapBlocks);
+    BENCH_CHECK(arena.mallocsPerRequest < plain.mallocsPerRequest);
+    std::printf("plain: %.1f mallocs/request, p50 %.1fus, p99 %.1fus\n", plain.mallocsPerRequest, plain.p50Micros, plain.p99Micros);
+    std::printf("arena: %.1f mallocs/request, p50 %.1fus, p99 %.1fus\n", arena.mallocsPerRequest, arena.p50Micros, arena.p99Micros);
+
+    // a last request that closes the connection, so the server has freed it before it stops
+    std::string closing = plainRequest;
+    closing.insert(closing.find("\r\n") + 2, "Connection: close\r\n");
+    boost::asio::write(socket, boost::asio::buffer(closing), ec);
+    while (!ec) {
+        socket.read_some(boost::asio::buffer(buffer), ec);
+    }
+    socket.close();
+    app.stop();
+    server.join();
+    return 0;
+}
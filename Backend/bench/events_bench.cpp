@@ -0,0 +1,78 @@
+// Appends account events, then rebuilds the projections with AccountEvents::load, with and without a snapshot.
+// Usage: events_bench [accounts] [transfers]
+
+#include "BenchSupport.h"
+#include "AccountEvents.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace {
+    bool sameStates(AccountEvents& expected, AccountEvents& loaded, int accounts) {
+        for (int accountID = 0; accountID < accounts; accountID++) {
+            AccountEvents::State a;
+            AccountEvents::State b;
+            if (!expected.find(accountID, a) || !loaded.find(accountID, b)) {
+                return false;
+            }
+            if (a.balanceCents != b.balanceCents || a.limitCents != b.limitCents || a.userID != b.userID || a.kind != b.kind) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int accounts = static_cast<int>(bench::argument(argc, argv, 1, 10000));
+    const int transfers = static_cast<int>(bench::argument(argc, argv, 2, 100000));
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "banking-events-bench";
+    std::filesystem::remove_all(directory);
+
+    auto writer = std::make_unique<AccountEvents>();
+    writer->load(directory.string());
+    bench::Stopwatch appending;
+    for (int accountID = 0; accountID < accounts; accountID++) {
+        writer->open(accountID, accountID / 2, accountID % 2 ? AccountEvents::Kind::Checkings : AccountEvents::Kind::Savings, 100.0);
+    }
+    writer->limitChanged(1, 250.0);
+    uint32_t x = 1;
+    for (int i = 0; i < transfers; i++) {
+        x = x * 1103515245 + 12345;
+        const int from = static_cast<int>((x >> 8) % accounts);
+        x = x * 1103515245 + 12345;
+        writer->transferred(from, static_cast<int>((x >> 8) % accounts), 0.01 * (x % 1000));
+        if (i == transfers / 2) {
+            writer->snapshot(); // the second half of the transfers is replayed from the log
+        }
+    }
+    const uint64_t events = static_cast<uint64_t>(accounts) + 1 + transfers;
+    std::printf("appended %llu events in %.3fs\n", static_cast<unsigned long long>(events), appending.seconds());
+    writer->stop();
+
+    {
+        AccountEvents loaded;
+        const AccountEvents::LoadStats stats = loaded.load(directory.string());
+        BENCH_CHECK(stats.accounts == static_cast<std::size_t>(accounts));
+        BENCH_CHECK(stats.snapshotSequence > 0 && stats.snapshotSequence + stats.replayed == events);
+        BENCH_CHECK(sameStates(*writer, loaded, accounts));
+        std::printf("load with snapshot: %zu accounts, %llu events replayed in %.3fs\n", stats.accounts,
+                    static_cast<unsigned long long>(stats.replayed), stats.seconds);
+        loaded.stop();
+    }
+
+    std::filesystem::remove(directory / "snapshot.bin");
+    {
+        AccountEvents loaded;
+        const AccountEvents::LoadStats stats = loaded.load(directory.string());
+        BENCH_CHECK(stats.snapshotSequence == 0 && stats.replayed == events);
+        BENCH_CHECK(sameStates(*writer, loaded, accounts));
+        std::printf("load from the log only: %zu accounts, %llu events replayed in %.3fs\n", stats.accounts,
+                    static_cast<unsigned long long>(stats.replayed), stats.seconds);
+        loaded.stop();
+    }
+
+    writer.reset();
+    std::filesystem::remove_all(directory);
+    return 0;
+}
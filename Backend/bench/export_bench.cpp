@@ -0,0 +1,83 @@
+// Streams one account's whole history through TransactionExport as CSV and NDJSON.
+// Usage: export_bench [rows]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+#include "PriorityScheduler.h"
+#include "TransactionExport.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+    struct StreamStats {
+        std::size_t bytes = 0;
+        std::size_t lines = 0;
+        std::size_t largestChunk = 0;
+        std::string lastLine;
+    };
+
+    /**
+     * @brief Pulls chunks the way a connection does: a source that has nothing yet parks on the
+     * waker, and the page read's completion resumes it on the io_service.
+     */
+    StreamStats drain(const std::function<bool(std::string&, const crow::stream_waker&)>& source) {
+        boost::asio::io_service io;
+        auto work = boost::asio::make_work_guard(io);
+        auto wakeup = std::make_shared<crow::detail::stream_wakeup>();
+        wakeup->io = &io;
+        wakeup->resume = [] {};
+        const crow::stream_waker waker(wakeup);
+
+        StreamStats stats;
+        std::string chunk;
+        bool more = true;
+        while (more) {
+            chunk.clear();
+            more = source(chunk, waker);
+            stats.bytes += chunk.size();
+            stats.largestChunk = std::max(stats.largestChunk, chunk.size());
+            stats.lines += std::count(chunk.begin(), chunk.end(), '\n');
+            const std::size_t end = chunk.find_last_not_of("\r\n");
+            if (end != std::string::npos) {
+                const std::size_t newline = chunk.rfind('\n', end);
+                const std::size_t begin = newline == std::string::npos ? 0 : newline + 1;
+                stats.lastLine = chunk.substr(begin, end + 1 - begin);
+            }
+            if (more && chunk.empty()) {
+                io.run_one();
+            }
+        }
+        // as a closing connection does, so a late wake-up does nothing
+        std::lock_guard<std::mutex> lock(wakeup->mutex);
+        wakeup->io = nullptr;
+        return stats;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int rows = static_cast<int>(bench::argument(argc, argv, 1, 20000));
+    const bench::History history(1, rows); // one account holding the whole history
+    PriorityScheduler scheduler(2);
+    const TransactionExport::PageReader reader = [&history](int accountID, int after, std::size_t limit) {
+        return history.accountPage(accountID, after, limit);
+    };
+
+    for (const auto format : { TransactionExport::Format::Csv, TransactionExport::Format::Ndjson }) {
+        const bool csv = format == TransactionExport::Format::Csv;
+        const bench::Stopwatch stopwatch;
+        const StreamStats stats = drain(TransactionExport::source(0, format, reader, scheduler));
+        const double seconds = stopwatch.seconds();
+
+        BENCH_CHECK(stats.lines == static_cast<std::size_t>(rows) + (csv ? 1 : 0));
+        const std::string lastID = std::to_string(rows);
+        BENCH_CHECK(csv ? stats.lastLine.compare(0, lastID.size() + 1, lastID + ",") == 0
+                        : stats.lastLine.find("\"transactionID\":" + lastID + ",") != std::string::npos);
+        // a chunk is one page, whatever the history's length
+        BENCH_CHECK(stats.largestChunk < TransactionExport::kPageSize * 256);
+        std::printf("%-6s %d rows, %.1f MB in %.3fs: %.0f rows/s, largest chunk %zu bytes\n", csv ? "csv" : "ndjson", rows,
+                    stats.bytes / 1e6, seconds, rows / seconds, stats.largestChunk);
+    }
+    return 0;
+}
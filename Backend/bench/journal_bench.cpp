@@ -0,0 +1,72 @@
+// Posts transfers from several threads through Journal::post, then re-derives the balances with verify().
+// Usage: journal_bench [accounts] [threads] [transfers per thread]
+
+#include "BenchSupport.h"
+#include "Journal.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+int main(int argc, char** argv) {
+    const int accounts = static_cast<int>(bench::argument(argc, argv, 1, 1000));
+    const int threads = static_cast<int>(bench::argument(argc, argv, 2, 4));
+    const int perThread = static_cast<int>(bench::argument(argc, argv, 3, 20000));
+    Journal& journal = Journal::instance();
+
+    for (int accountID = 0; accountID < accounts; accountID++) {
+        journal.open(accountID, 1000.0);
+    }
+    bool rejected = false;
+    try {
+        journal.post(Journal::Entry{ { { 0, -500 }, { 1, 400 } } });
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    BENCH_CHECK(rejected);
+
+    // transfers between pseudo-random accounts; some overdraw and are refused
+    std::atomic<long> refused{ 0 };
+    std::vector<std::thread> posters;
+    const bench::Stopwatch posting;
+    for (int thread = 0; thread < threads; thread++) {
+        posters.emplace_back([&, thread] {
+            uint32_t x = static_cast<uint32_t>(thread) + 1;
+            for (int i = 0; i < perThread; i++) {
+                x = x * 1103515245 + 12345;
+                const int from = static_cast<int>((x >> 8) % accounts);
+                x = x * 1103515245 + 12345;
+                const int to = static_cast<int>((x >> 8) % accounts);
+                if (!journal.post(Journal::transfer(from, to, 1.0 + (x % 5000) / 100.0))) {
+                    refused++;
+                }
+            }
+        });
+    }
+    for (auto& poster : posters) {
+        poster.join();
+    }
+    const double postSeconds = posting.seconds();
+    const long posts = static_cast<long>(threads) * perThread;
+    std::printf("posted %ld transfers from %d threads in %.3fs: %.0f posts/s, %ld refused for funds\n", posts, threads, postSeconds,
+                posts / postSeconds, refused.load());
+
+    int64_t total = 0;
+    for (int accountID = 0; accountID < accounts; accountID++) {
+        const double balance = journal.balance(accountID);
+        BENCH_CHECK(balance >= 0.0);
+        total += Journal::toCents(balance);
+    }
+    BENCH_CHECK(total == static_cast<int64_t>(accounts) * 100000); // transfers only move money
+
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t workers = 1; workers <= hardware; workers *= 2) {
+        const Journal::VerifyResult result = journal.verify(workers);
+        BENCH_CHECK(result.ok && result.mismatches.empty() && result.unbalancedEntries == 0);
+        BENCH_CHECK(result.entries == static_cast<uint64_t>(accounts + posts - refused.load()));
+        std::printf("verify threads=%zu: %llu entries, %llu legs, %zu accounts in %.3fs\n", workers,
+                    static_cast<unsigned long long>(result.entries), static_cast<unsigned long long>(result.legs), result.accounts,
+                    result.seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Parses the same transfer bodies with TransferRequest::parse and with crow::json::load, valid and
+// malformed, and checks that both accept and reject the same ones.
+// Usage: json_bench [rounds]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+#include "JsonIndex.h"
+
+namespace {
+    struct Body {
+        std::string text;
+        bool valid; // whether a transfer can be read from it
+    };
+
+    // what the transfer route did before JsonIndex: build the tree, then check each field's type
+    bool parseWithCrow(const std::string& body, TransferRequest& out) {
+        const crow::json::rvalue json = crow::json::load(body);
+        if (!json || json.t() != crow::json::type::Object || !json.has("senderId") || !json.has("recipientId") || !json.has("amount")) {
+            return false;
+        }
+        const crow::json::rvalue& sender = json["senderId"];
+        const crow::json::rvalue& recipient = json["recipientId"];
+        const crow::json::rvalue& amount = json["amount"];
+        if (sender.t() != crow::json::type::String || recipient.t() != crow::json::type::String || amount.t() != crow::json::type::Number) {
+            return false;
+        }
+        out.senderId = sender.s();
+        out.recipientId = recipient.s();
+        out.amount = amount.d();
+        return true;
+    }
+
+    std::vector<Body> bodies() {
+        const std::string memo(200, 'x');
+        return {
+            { R"({"senderId":"1001","recipientId":"1002","amount":25.5})", true },
+            { R"({ "amount" : 1e3 , "recipientId" : "2002", "senderId" : "1001" })", true },
+            { R"({"senderId":"1001","recipientId":"1002","amount":12,"memo":")" + memo + R"(","tags":[1,2,{"a":null}]})", true },
+            { R"({"senderId":"1001","recipientId":"1002","amount":25.5)", false },     // unterminated object
+            { R"({"senderId":"1001","recipientId":"1002","amount":25.5,})", false },   // trailing comma
+            { R"({"senderId":"1001","recipientId":"1002","amount":"25.5"})", false },  // amount is a string
+            { R"({"senderId":1001,"recipientId":"1002","amount":25.5})", false },      // senderId is a number
+            { R"({"senderId":"1001","amount":25.5})", false },                         // recipientId missing
+            { R"({"senderId":"10\q1","recipientId":"1002","amount":25.5})", false },   // bad escape
+            { R"(["1001","1002",25.5])", false },                                      // root is not an object
+            { "", false },
+        };
+    }
+}
+
+int main(int argc, char** argv) {
+    const int rounds = static_cast<int>(bench::argument(argc, argv, 1, 20000));
+    const std::vector<Body> cases = bodies();
+
+    std::size_t bytes = 0;
+    for (const Body& body : cases) {
+        TransferRequest indexed;
+        TransferRequest loaded;
+        BENCH_CHECK(TransferRequest::parse(body.text, indexed) == body.valid);
+        BENCH_CHECK(parseWithCrow(body.text, loaded) == body.valid);
+        if (body.valid) {
+            BENCH_CHECK(indexed.senderId == loaded.senderId && indexed.recipientId == loaded.recipientId && indexed.amount == loaded.amount);
+        }
+        bytes += body.text.size();
+    }
+    BENCH_CHECK(rounds > 0);
+
+    const auto measure = [&](bool valid, auto parse) {
+        long parsed = 0;
+        long accepted = 0;
+        const bench::Stopwatch stopwatch;
+        for (int round = 0; round < rounds; round++) {
+            for (const Body& body : cases) {
+                if (body.valid != valid) {
+                    continue;
+                }
+                TransferRequest out;
+                accepted += parse(body.text, out);
+                parsed++;
+            }
+        }
+        const double seconds = stopwatch.seconds();
+        BENCH_CHECK(accepted == (valid ? parsed : 0));
+        return parsed / seconds;
+    };
+    const auto index = [](const std::string& body, TransferRequest& out) { return TransferRequest::parse(body, out); };
+    const auto crow = [](const std::string& body, TransferRequest& out) { return parseWithCrow(body, out); };
+
+    const double indexValid = measure(true, index);
+    const double crowValid = measure(true, crow);
+    const double indexMalformed = measure(false, index);
+    const double crowMalformed = measure(false, crow);
+
+    std::printf("%zu bodies, %zu bytes, %d rounds\n", cases.size(), bytes, rounds);
+    std::printf("valid:     JsonIndex %.0f/s, crow::json::load %.0f/s\n", indexValid, crowValid);
+    std::printf("malformed: JsonIndex %.0f/s, crow::json::load %.0f/s\n", indexMalformed, crowMalformed);
+    return 0;
+}
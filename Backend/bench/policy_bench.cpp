@@ -0,0 +1,115 @@
+// Applies the same withdrawals once through the virtual Account::withdraw and once through AccountBatch.
+// Usage: policy_bench [accounts] [withdrawals per account]
+
+#include "BenchSupport.h"
+#include "AccountBatch.h"
+#include "AccountEvents.h"
+#include "Journal.h"
+
+#include <deque>
+
+namespace {
+    double openingBalance(int index) { return 200.0 + (index % 7) * 100.0; }
+
+    // Amounts from 0.01 to 400.00, so some withdrawals hit the balance or the withdrawal limit
+    double amountFor(int index, int round) { return Journal::fromCents((static_cast<int64_t>(index) * 7919 + round * 104729) % 40000 + 1); }
+
+    // Account has no virtual destructor, so each kind is owned as itself and only called through Account&
+    struct Accounts {
+        std::deque<Account> standard;
+        std::deque<CheckingsAccount> checkings;
+        std::deque<SavingsAccount> savings;
+
+        Account& add(int accountID, int index) {
+            switch (index % 3) {
+            case 0:
+                return checkings.emplace_back(accountID, openingBalance(index), index, "Checkings", 250.0);
+            case 1:
+                return savings.emplace_back(accountID, openingBalance(index), index, "Savings", SavingsAccount::getInterestRate());
+            default:
+                return standard.emplace_back(accountID, openingBalance(index), index, "");
+            }
+        }
+    };
+
+    bool eventsMatchJournal(int accountID) {
+        AccountEvents::State state;
+        return AccountEvents::instance().find(accountID, state) && state.balanceCents == Journal::toCents(Journal::instance().balance(accountID));
+    }
+}
+
+int main(int argc, char** argv) {
+    const int accounts = static_cast<int>(bench::argument(argc, argv, 1, 3000));
+    const int rounds = static_cast<int>(bench::argument(argc, argv, 2, 20));
+    const long withdrawals = static_cast<long>(accounts) * rounds;
+    Journal& journal = Journal::instance();
+
+    // accounts 0..n-1 withdraw one at a time through Account&, accounts n..2n-1 through the batch
+    Accounts owned;
+    std::vector<Account*> objects;
+    Accounts twins;
+    for (int i = 0; i < accounts; i++) {
+        objects.push_back(&owned.add(i, i));
+        twins.add(accounts + i, i);
+    }
+    AccountBatch batch;
+    for (const Account& account : twins.standard) {
+        BENCH_CHECK(batch.add(account));
+    }
+    for (const CheckingsAccount& account : twins.checkings) {
+        BENCH_CHECK(batch.add(account));
+    }
+    for (const SavingsAccount& account : twins.savings) {
+        BENCH_CHECK(batch.add(account));
+    }
+    // an ID that is already in the batch is refused and leaves nothing behind
+    BENCH_CHECK(!batch.add(Account(accounts, 5.0, 0, "")));
+    BENCH_CHECK(batch.size() == static_cast<std::size_t>(accounts));
+    BENCH_CHECK(batch.toAccounts().size() == static_cast<std::size_t>(accounts));
+
+    std::vector<WithdrawalRequest> requests;
+    requests.reserve(static_cast<std::size_t>(withdrawals));
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < accounts; i++) {
+            requests.push_back({ accounts + i, amountFor(i, round) });
+        }
+    }
+
+    const bench::Stopwatch virtualClock;
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < accounts; i++) {
+            Account& account = *objects[i];
+            account.withdraw(amountFor(i, round));
+        }
+    }
+    const double virtualSeconds = virtualClock.seconds();
+
+    const bench::Stopwatch batchClock;
+    const std::vector<bool> results = batch.withdraw(requests);
+    const double batchSeconds = batchClock.seconds();
+
+    long succeeded = 0;
+    for (bool result : results) {
+        succeeded += result;
+    }
+    BENCH_CHECK(succeeded > 0 && succeeded < withdrawals);
+    for (int i = 0; i < accounts; i++) {
+        BENCH_CHECK(journal.balance(i) == journal.balance(accounts + i));
+        BENCH_CHECK(batch.getBalance(accounts + i) == journal.balance(accounts + i));
+        BENCH_CHECK(eventsMatchJournal(accounts + i));
+    }
+
+    for (SavingsAccount& account : owned.savings) {
+        account.applyInterest();
+    }
+    batch.applyInterest();
+    for (int i = 0; i < accounts; i++) {
+        BENCH_CHECK(journal.balance(i) == journal.balance(accounts + i));
+        BENCH_CHECK(eventsMatchJournal(accounts + i));
+    }
+    BENCH_CHECK(journal.verify().ok);
+
+    std::printf("virtual withdraw: %ld withdrawals in %.3fs, %.0f/s\n", withdrawals, virtualSeconds, withdrawals / virtualSeconds);
+    std::printf("AccountBatch:     %ld withdrawals in %.3fs, %.0f/s (%ld succeeded)\n", withdrawals, batchSeconds, withdrawals / batchSeconds, succeeded);
+    return 0;
+}
@@ -0,0 +1,44 @@
+// Reconciles stored balances against the whole transaction set with Reconciler::run.
+// Usage: reconcile_bench [accounts] [transactions]
+
+#include "BenchSupport.h"
+#include "Reconciler.h"
+
+#include <sstream>
+#include <thread>
+
+int main(int argc, char** argv) {
+    const int accounts = static_cast<int>(bench::argument(argc, argv, 1, 1000));
+    const int transactions = static_cast<int>(bench::argument(argc, argv, 2, 200000));
+    const bench::History history(accounts, transactions);
+    const Reconciler::ScanReader reader = [&history](int after, std::size_t limit) { return history.scanPage(after, limit); };
+
+    // every stored balance right, except: one off by a cent, one missing, one with no transactions
+    std::vector<Reconciler::StoredBalance> balances;
+    for (int accountID = 0; accountID < accounts; accountID++) {
+        if (accountID != 5) {
+            balances.push_back(Reconciler::StoredBalance{ accountID, Journal::fromCents(history.balanceCents(accountID)) });
+        }
+    }
+    balances[3].balance += 0.01;
+    balances.push_back(Reconciler::StoredBalance{ accounts + 1, 4.20 });
+
+    const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= hardware; threads *= 2) {
+        const Reconciler::Report report = Reconciler::run(reader, balances, threads);
+
+        BENCH_CHECK(report.transactions == static_cast<uint64_t>(transactions));
+        BENCH_CHECK(report.accounts == static_cast<std::size_t>(accounts) + 1);
+        BENCH_CHECK(report.mismatches.size() == 3);
+        BENCH_CHECK(report.mismatches[0].accountID == 3 && report.mismatches[0].storedCents - report.mismatches[0].historyCents == 1);
+        BENCH_CHECK(report.mismatches[1].accountID == 5 && !report.mismatches[1].stored);
+        BENCH_CHECK(report.mismatches[2].accountID == accounts + 1 && report.mismatches[2].transactions == 0);
+        std::printf("threads=%zu: %llu transactions, %zu accounts in %.3fs: %.0f transactions/s\n", threads,
+                    static_cast<unsigned long long>(report.transactions), report.accounts, report.seconds, report.transactionsPerSecond);
+    }
+
+    std::ostringstream csv;
+    Reconciler::writeCsv(Reconciler::run(reader, balances), csv);
+    BENCH_CHECK(csv.str().find("\n3,") != std::string::npos);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Looks URLs up in a route table of a few hundred <int>, <string> and <path> routes, the way
+// Router::handle does, and checks that each one resolves to its rule and parameters.
+// Usage: routing_bench [resources] [rounds]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+
+namespace {
+    struct Lookup {
+        std::string url;
+        unsigned rule;                  // 0 when nothing should match
+        std::vector<int64_t> ints;
+        std::vector<std::string> strings;
+    };
+
+    void expectMatch(const crow::Trie& trie, const Lookup& lookup, crow::routing_params& params) {
+        BENCH_CHECK(trie.find(lookup.url, params) == lookup.rule);
+        if (!lookup.rule) {
+            return;
+        }
+        BENCH_CHECK(params.int_params.size() == lookup.ints.size());
+        for (std::size_t i = 0; i < lookup.ints.size(); i++) {
+            BENCH_CHECK(params.int_params[i] == lookup.ints[i]);
+        }
+        BENCH_CHECK(params.string_params.size() == lookup.strings.size());
+        for (std::size_t i = 0; i < lookup.strings.size(); i++) {
+            BENCH_CHECK(params.get<std::string>(i) == lookup.strings[i]);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const int resources = static_cast<int>(bench::argument(argc, argv, 1, 75));
+    const int rounds = static_cast<int>(bench::argument(argc, argv, 2, 200));
+
+    // four routes per resource: a fixed path, an <int>, a <string> between fixed segments and a <path>
+    crow::Trie trie;
+    std::vector<Lookup> lookups;
+    unsigned rule = 1;
+    for (int r = 0; r < resources; r++) {
+        const std::string base = "/api/r" + std::to_string(r);
+        trie.add(base + "/health", rule);
+        lookups.push_back({ base + "/health", rule++, {}, {} });
+        trie.add(base + "/accounts/<int>", rule);
+        lookups.push_back({ base + "/accounts/" + std::to_string(1000 + r), rule++, { 1000 + r }, {} });
+        trie.add(base + "/users/<string>/accounts/<int>", rule);
+        lookups.push_back({ base + "/users/user" + std::to_string(r) + "/accounts/" + std::to_string(r - 50), rule++, { r - 50 }, { "user" + std::to_string(r) } });
+        trie.add("/static/r" + std::to_string(r) + "/<path>", rule);
+        lookups.push_back({ "/static/r" + std::to_string(r) + "/css/site.css", rule++, {}, { "css/site.css" } });
+    }
+    const std::size_t routes = rule - 1;
+
+    // urls that share a prefix with a route but match none: a wrong literal, a non-number for <int>, an extra segment
+    lookups.push_back({ "/api/r0/healthz", 0, {}, {} });
+    lookups.push_back({ "/api/r1/accounts/abc", 0, {}, {} });
+    lookups.push_back({ "/api/r2/users/bob/accounts/7/extra", 0, {}, {} });
+    lookups.push_back({ "/api/unknown", 0, {}, {} });
+    lookups.push_back({ "/api/r7", 0, {}, {} }); // ends inside an edge's key
+    lookups.push_back({ "/api/r" + std::to_string(resources) + "0/health", 0, {}, {} }); // shares a prefix with r<n>
+    trie.validate();
+
+    crow::routing_params params;
+    for (const Lookup& lookup : lookups) {
+        expectMatch(trie, lookup, params);
+    }
+
+    // the timed loop checks only the rule, so it measures the lookup and the parameter extraction
+    long found = 0;
+    const bench::Stopwatch stopwatch;
+    for (int round = 0; round < rounds; round++) {
+        for (const Lookup& lookup : lookups) {
+            found += trie.find(lookup.url, params) == lookup.rule;
+        }
+    }
+    const double seconds = stopwatch.seconds();
+    const long total = static_cast<long>(lookups.size()) * rounds;
+    BENCH_CHECK(found == total);
+
+    std::printf("%zu routes, %zu urls, %d rounds\n", routes, lookups.size(), rounds);
+    std::printf("%ld lookups in %.3fs, %.0f lookups/s\n", total, seconds, total / seconds);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Renders one month's statements for every account with StatementGenerator::run.
+// Usage: statement_bench [accounts] [transactions per account] [threads]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+#include "StatementGenerator.h"
+
+#include <atomic>
+#include <numeric>
+
+int main(int argc, char** argv) {
+    const int accounts = static_cast<int>(bench::argument(argc, argv, 1, 200));
+    const int perAccount = static_cast<int>(bench::argument(argc, argv, 2, 500));
+    const std::size_t threads = static_cast<std::size_t>(bench::argument(argc, argv, 3, 0));
+    const bench::History history(accounts, accounts * perAccount);
+    const StatementGenerator::PageReader reader = [&history](int accountID, int after, std::size_t limit) {
+        return history.accountPage(accountID, after, limit);
+    };
+    const std::string month = "2025-06";
+
+    // what every statement should say, worked out from the history directly
+    std::vector<int64_t> closing(accounts, 0);
+    std::size_t lines = 0;
+    for (int id = 1; id <= history.size(); id++) {
+        if (bench::History::month(id) <= 6) {
+            closing[history.accountOf(id)] += bench::History::cents(id);
+        }
+        lines += bench::History::month(id) == 6;
+    }
+
+    // A template reduced to the figures lets every statement be checked.
+    StatementGenerator figures(crow::mustache::compile("{{accountID}} {{closingBalance}} {{transactionCount}}"));
+    std::atomic<std::size_t> wrong{ 0 };
+    figures.run(std::vector<int>{ 0, accounts - 1 }, month, reader, [&](int accountID, const std::string& document) {
+        char expected[64];
+        std::snprintf(expected, sizeof(expected), "%d %.2f ", accountID, Journal::fromCents(closing[accountID]));
+        wrong += document.compare(0, std::string(expected).size(), expected) != 0;
+    });
+    BENCH_CHECK(wrong == 0);
+
+    std::vector<int> accountIDs(accounts);
+    std::iota(accountIDs.begin(), accountIDs.end(), 0);
+    StatementGenerator generator;
+    std::atomic<std::size_t> largest{ 0 };
+    const StatementGenerator::RunStats stats = generator.run(accountIDs, month, reader, [&largest](int, const std::string& document) {
+        std::size_t seen = largest.load();
+        while (document.size() > seen && !largest.compare_exchange_weak(seen, document.size())) {
+        }
+    }, threads);
+
+    BENCH_CHECK(stats.statements == static_cast<std::size_t>(accounts) && stats.failed == 0);
+    BENCH_CHECK(stats.transactions == lines);
+    std::printf("%zu statements over %d transactions in %.3fs: %.0f statements/s, %.0f history rows/s, %.1f MB, largest %zu bytes\n",
+                stats.statements, history.size(), stats.seconds, stats.statements / stats.seconds, history.size() / stats.seconds,
+                stats.bytes / 1e6, largest.load());
+    return 0;
+}
@@ -0,0 +1,99 @@
+// Keeps a large number of connection deadlines live in crow's timer wheel, re-arms them the way
+// keep-alive connections do, and checks that each one fires once, never early, unless cancelled.
+// Usage: timer_wheel_bench [live timers] [re-arms] [longest timeout in ms]
+
+#include "asio_compat.h"
+#include "crow_all.h"
+#include "BenchSupport.h"
+
+#include <thread>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point deadline;
+        bool cancelled = false;
+        int fired = 0;
+        bool early = false;
+    };
+}
+
+int main(int argc, char** argv) {
+    const std::size_t live = static_cast<std::size_t>(bench::argument(argc, argv, 1, 100000));
+    const std::size_t rearms = static_cast<std::size_t>(bench::argument(argc, argv, 2, 1000000));
+    const long longest = bench::argument(argc, argv, 3, 800);
+
+    // 1ms ticks; with 512 slots, timeouts past 512ms wrap the wheel and wait extra rounds
+    boost::asio::io_service io;
+    crow::detail::timer_wheel wheel(std::chrono::milliseconds(1));
+    wheel.set_io_service(io);
+
+    std::vector<Timer> timers;
+    timers.reserve(live + rearms);
+    std::vector<std::size_t> armed(live); // the timer each connection slot currently holds
+    std::vector<crow::detail::timer_wheel::key> keys(live);
+    const auto arm = [&](std::size_t slot, long timeoutMs) {
+        const std::size_t id = timers.size();
+        timers.push_back(Timer{ Clock::now() + std::chrono::milliseconds(timeoutMs) });
+        armed[slot] = id;
+        keys[slot] = wheel.add([&timers, id] {
+            Timer& timer = timers[id];
+            timer.fired++;
+            timer.early |= Clock::now() < timer.deadline;
+        }, std::chrono::milliseconds(timeoutMs));
+    };
+    const auto timeoutFor = [longest](std::size_t n) { return 1 + static_cast<long>(n * 7919 % static_cast<std::size_t>(longest)); };
+
+    const bench::Stopwatch addClock;
+    for (std::size_t slot = 0; slot < live; slot++) {
+        arm(slot, timeoutFor(slot));
+    }
+    const double addSeconds = addClock.seconds();
+    BENCH_CHECK(wheel.size() == live);
+
+    // a request arriving on a kept-alive connection cancels its idle deadline and arms a new one
+    const bench::Stopwatch rearmClock;
+    for (std::size_t n = 0; n < rearms; n++) {
+        const std::size_t slot = n * 104729 % live;
+        timers[armed[slot]].cancelled = true;
+        wheel.cancel(keys[slot]);
+        arm(slot, timeoutFor(n + live));
+    }
+    const double rearmSeconds = rearmClock.seconds();
+    BENCH_CHECK(wheel.size() == live);
+
+    // a cancelled key is cleared, and cancelling it again does nothing
+    crow::detail::timer_wheel::key stale = keys[0];
+    wheel.cancel(stale);
+    timers[armed[0]].cancelled = true;
+    wheel.cancel(stale);
+    BENCH_CHECK(stale.first == nullptr && wheel.size() == live - 1);
+
+    // drive the wheel like the io thread's tick until every live deadline has fired
+    double processSeconds = 0;
+    long ticks = 0;
+    const Clock::time_point giveUp = Clock::now() + std::chrono::milliseconds(longest * 4 + 2000);
+    while (wheel.size() > 0 && Clock::now() < giveUp) {
+        const bench::Stopwatch processClock;
+        wheel.process();
+        processSeconds += processClock.seconds();
+        ticks++;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    BENCH_CHECK(wheel.size() == 0);
+
+    std::size_t fired = 0;
+    for (const Timer& timer : timers) {
+        BENCH_CHECK(timer.fired == (timer.cancelled ? 0 : 1));
+        BENCH_CHECK(!timer.early);
+        fired += timer.fired;
+    }
+    BENCH_CHECK(fired == live - 1);
+
+    std::printf("%zu live timers, %zu re-arms, timeouts up to %ldms\n", live, rearms, longest);
+    std::printf("add:     %.0f/s\n", live / addSeconds);
+    std::printf("re-arm:  %.0f/s (cancel + add)\n", rearms / rearmSeconds);
+    std::printf("process: %zu fired over %ld calls in %.3fs, %.0f fired/s\n", fired, ticks, processSeconds, fired / processSeconds);
+    return 0;
+}
@@ -14,11 +14,17 @@
 #include <string>
 #include <iostream>
 
+#include "AccountPolicy.h"
+
+template <typename T>
+struct JsonFields;
+
 class Account {
 public:
     Account(int accountID, double balance, int userID, std::string accountType); // Constructor function that contructs an Account object
 
     int getAccountID() const; // A getter function that returns the account's ID
+    int getUserID() const; // A getter function that returns the ID of the user that owns the account
     void setAccountID(int newID); // A setter function that sets the account's current ID to a new/different ID
     double getBalance() const; // A getter function that returns the account's balance
     void setBalance(double newBalance); // A setter function that sets the account's balance to a new/different balance
@@ -26,11 +32,20 @@ public:
     void setAccountType(std::string newType); // A setter function that sets the account's type to a new/different balance
     void deposit(double amount); // A function that deposits an 'amount' of money to the account's balance
     virtual void withdraw(double amount); // A function that withdraws an 'amount' of money from the account's balance. It is set as 'virtual' since it is overrode in the 'CheckingsAccount' class
-    void transfer(Account& recipient, double amount); // A function that transfers money from one account (sender) to a 'recipient'
+    bool transfer(Account& recipient, double amount); // A function that transfers money from one account (sender) to a 'recipient'. Returns false if the transfer was refused
+    void publishBalance() const; // A function that publishes the account's balance to the balance feed once a change has been saved
+
+    std::string toJson() const; // A function that returns the account's information as a JSON object
 
-    static Account fetchAccount(int accountID);
+    static Account fetchAccount(int accountID); // Rebuilds the account from its event stream when it has one
+
+protected:
+    void openLedgers(); // Brings the account into the journal and the event stream the first time either sees it
+    static bool isValidAmount(double amount); // Checks that an amount is a positive number of cents, the only amounts the journal accepts
 
 private:
+    friend struct JsonFields<Account>; // Lets the JSON field description in 'ModelJson.h' read the private members
+
     int accountID; // The account's ID
     double balance; // The account's balance
     int userID; // The account's user ID, which is used to locate the user that owns the account
@@ -0,0 +1,82 @@
+#ifndef ACCOUNT_BATCH_H
+#define ACCOUNT_BATCH_H
+
+/**
+* Author: Group 13
+* Date: 28/3/2025
+*
+* @brief A header file that defines the "AccountBatch" class which groups many accounts by their kind ("Account", "CheckingsAccount", or "SavingsAccount") and applies withdrawals and interest to a whole group at once.
+*
+* AccountBatch.h:
+* This is a header file that defines the "AccountBatch" class. Accounts added to a batch are stored in one "lane" per kind, where the balances sit next to each other in memory.
+* Every operation runs one loop per lane using the policies from 'AccountPolicy.h', so the rules are known at compile time and need no virtual calls.
+* Each lane's changes are posted to the journal as one entry, and every withdrawal or interest payment is still appended to its account's event stream.
+*/
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "Account.h"
+#include "AccountPolicy.h"
+#include "CheckingsAccount.h"
+#include "SavingsAccount.h"
+
+using AnyAccount = std::variant<Account, CheckingsAccount, SavingsAccount>; // Any one of the account kinds, used when the kind is only known at runtime
+
+struct WithdrawalRequest {
+    int accountID; // The account to withdraw from
+    double amount; // The amount to be withdrawn
+};
+
+class AccountBatch {
+public:
+    bool add(const Account& account); // A function that adds a plain account to the batch. Returns false if the batch already has an account with the same ID
+    bool add(const CheckingsAccount& account); // A function that adds a Checkings Account to the batch. Returns false if the batch already has an account with the same ID
+    bool add(const SavingsAccount& account); // A function that adds a Savings Account to the batch. Returns false if the batch already has an account with the same ID
+    bool add(const AnyAccount& account); // A function that adds an account of any kind to the batch
+
+    std::size_t size() const; // A getter function that returns the number of accounts in the batch
+    bool contains(int accountID) const; // A function that checks if an account is in the batch
+    double getBalance(int accountID) const; // A getter function that returns the balance of an account in the batch after the last batch operation
+
+    std::vector<bool> withdraw(const std::vector<WithdrawalRequest>& requests); // A function that applies many withdrawals, grouped by account kind, and returns which ones succeeded
+    void applyInterest(); // A function that applies interest to every Savings Account in the batch
+
+    std::vector<AnyAccount> toAccounts() const; // A function that turns the batch back into account objects with their current balances
+
+private:
+    enum class Kind { Standard, Checkings, Savings };
+
+    // One lane stores every account of a single kind as parallel arrays
+    template <typename Policy>
+    struct Lane {
+        std::vector<int> accountIDs;
+        std::vector<int> userIDs;
+        std::vector<std::string> accountTypes;
+        std::vector<int64_t> balanceCents;
+        std::vector<Policy> policies;
+
+        void push(const Account& account, Policy policy);
+    };
+
+    // Where an account lives inside the batch
+    struct Slot {
+        Kind kind;
+        std::size_t index;
+    };
+
+    bool reserve(const Account& account, Kind kind, std::size_t index); // Claims the account's ID and opens it in the journal and the event stream
+
+    template <typename Policy>
+    static void withdrawLane(Lane<Policy>& lane, const std::vector<std::pair<std::size_t, std::size_t>>& work, const std::vector<WithdrawalRequest>& requests, std::vector<bool>& results);
+
+    Lane<StandardPolicy> standard;
+    Lane<CheckingsPolicy> checkings;
+    Lane<SavingsPolicy> savings;
+    std::unordered_map<int, Slot> slots; // Account ID -> lane and index
+};
+
+#endif // ACCOUNT_BATCH_H
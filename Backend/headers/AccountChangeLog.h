@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "ShardedMap.h"
+#include "Transaction.h"
+
+/**
+ * @brief Ordered per-account index of changes, for delta sync of transaction history.
+ *
+ * Each account keeps its newest kMaxChanges changes in commit order: new transactions and
+ * balance updates, numbered by a per-account sequence. A client holds the sequence it last saw
+ * as its cursor. delta() answers with what happened after that cursor in O(changes since the
+ * cursor):
+ *
+ *     {"cursor":57,"reset":false,"more":false,"balance":120.5,"transactions":[...]}
+ *
+ * - transactions are the ones added after the cursor;
+ * - balance is the latest balance if it changed after the cursor, otherwise null.
+ *
+ * Committed transactions are never reversed or edited, so a client only ever adds to its copy.
+ *
+ * A cursor that has fallen out of the index, or is ahead of it after a restart, gets
+ * `"reset":true` with the current head; the client reloads the full history once.
+ */
+class AccountChangeLog {
+public:
+    static constexpr std::size_t kMaxChanges = 4096;
+    static constexpr std::size_t kMaxChangesPerDelta = 1000;
+
+    static AccountChangeLog& instance();
+
+    AccountChangeLog(const AccountChangeLog&) = delete;
+    AccountChangeLog& operator=(const AccountChangeLog&) = delete;
+
+    /**
+     * @brief Records a committed transaction.
+     */
+    void recordTransaction(const Transaction& transaction);
+
+    /**
+     * @brief Records an account's new balance.
+     */
+    void recordBalance(int accountID, double balance);
+
+    /**
+     * @brief Writes the changes after a cursor as JSON.
+     * @param accountID The account.
+     * @param since The client's cursor, or nullptr for a client with no history yet.
+     * @return The JSON response body.
+     */
+    std::string delta(int accountID, const uint64_t* since);
+
+private:
+    enum class Kind : uint8_t { Transaction, Balance };
+
+    struct Change {
+        uint64_t sequence;
+        Kind kind;
+        double balance;
+        std::shared_ptr<const std::string> json; // the transaction, encoded once
+    };
+
+    struct Log {
+        std::mutex mutex;
+        std::deque<Change> changes;
+        uint64_t head = 0;
+    };
+
+    AccountChangeLog() = default;
+
+    void append(int accountID, Change change);
+
+    ShardedMap<int, Log> logs;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ShardedMap.h"
+
+/**
+ * @brief Append-only event stream behind every account, with projections rebuilt from it.
+ *
+ * An account is the result of its events: Opened, Deposited, Withdrawn, Transferred and
+ * LimitChanged. Each event gets the next sequence number, is written to `events.log` in the
+ * store's directory as a fixed-size record, and is applied to the in-memory projection of the
+ * accounts it touches. The projection of an account is its current state plus the sequence of
+ * the last event applied to it.
+ *
+ * Events are facts: callers append them once the change has been accepted (the journal checks
+ * funds), so append never rejects one for lack of funds.
+ *
+ * Every kSnapshotEvery events a background thread writes the projections to `snapshot.bin`. The
+ * snapshot is fuzzy: shards are copied one at a time while appends go on. It records the last
+ * sequence written before it started, and every account carries its own last sequence. So
+ * load() reads the snapshot, then replays only the log after that sequence, skipping events an
+ * account already includes. Snapshot shards are read on several threads.
+ */
+class AccountEvents {
+public:
+    enum class Type : uint8_t { Opened = 1, Deposited, Withdrawn, Transferred, LimitChanged };
+    enum class Kind : uint8_t { Unspecified, Savings, Checkings };
+
+    // On disk as is; the log is only read back on the machine that wrote it.
+    struct Event {
+        uint64_t sequence;
+        int32_t accountID;
+        int32_t otherID;  // the owner's user ID for Opened, the recipient for Transferred
+        int64_t cents;    // the opening balance, the amount moved, or the new withdrawal limit
+        Type type;
+        Kind kind;        // Opened only
+        uint8_t reserved[6];
+    };
+
+    struct State {
+        int32_t accountID;
+        int32_t userID;
+        int64_t balanceCents;
+        int64_t limitCents; // 0 if no withdrawal limit has been set
+        uint64_t version;   // the sequence of the last event applied
+        Kind kind;
+        uint8_t reserved[7];
+    };
+
+    struct LoadStats {
+        std::size_t accounts = 0;
+        uint64_t snapshotSequence = 0; // 0 if there was no snapshot
+        uint64_t replayed = 0;         // log events after the snapshot's sequence
+        double seconds = 0.0;
+    };
+
+    static constexpr uint64_t kSnapshotEvery = 1000000;
+
+    /**
+     * @brief The process-wide stream; main() loads it from disk before serving.
+     */
+    static AccountEvents& instance();
+
+    /**
+     * @brief An empty stream kept in memory until load() is called.
+     */
+    AccountEvents();
+    ~AccountEvents();
+
+    AccountEvents(const AccountEvents&) = delete;
+    AccountEvents& operator=(const AccountEvents&) = delete;
+
+    static Kind kindOf(const std::string& accountType);
+    static std::string accountType(Kind kind);
+
+    /**
+     * @brief Rebuilds the projections from a directory and appends to its log from then on.
+     * @param directory Created if it does not exist.
+     * @param threads Snapshot readers; 0 uses one per hardware thread.
+     * @throws std::runtime_error If the directory, snapshot or log cannot be used.
+     */
+    LoadStats load(const std::string& directory, std::size_t threads = 0);
+
+    /**
+     * @brief Appends Opened if the account has no events yet.
+     */
+    void open(int accountID, int userID, Kind kind, double balance);
+
+    /**
+     * @return The event's sequence, or 0 if an account it names has not been opened.
+     */
+    uint64_t deposited(int accountID, double amount);
+    uint64_t withdrawn(int accountID, double amount);
+    uint64_t transferred(int fromAccountID, int toAccountID, double amount);
+    uint64_t limitChanged(int accountID, double limit);
+
+    bool find(int accountID, State& state);
+
+    /**
+     * @brief Copies every account's projection. Shards are copied one at a time while appends go on.
+     */
+    std::vector<State> states();
+
+    /**
+     * @brief Writes a snapshot now, whatever the event count.
+     * @return The sequence it covers.
+     */
+    uint64_t snapshot();
+
+    /**
+     * @brief Stops the snapshot thread and flushes the log.
+     */
+    void stop();
+
+private:
+    using Accounts = ShardedMap<int, State>;
+    using Shard = Accounts::Shard;
+
+    uint64_t append(Event event);
+    uint64_t write(Event& event);
+    static void apply(State& state, const Event& event);
+    void replay(const Event& event);
+    void run();
+
+    Accounts accounts; // used under the shard lock, so that an event and its effect are atomic
+
+    // the log; sequence order is write order
+    std::mutex logMutex;
+    std::FILE* log = nullptr;
+    uint64_t lastSequence = 0;
+    std::string directory;
+
+    // snapshots
+    std::mutex snapshotMutex; // one snapshot at a time
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    uint64_t snapshotSequence = 0;   // guarded by logMutex
+    bool snapshotRequested = false;  // guarded by logMutex
+    bool snapshotDue = false;        // guarded by wakeMutex
+    bool stopping = false;
+    std::thread snapshotter;
+};
@@ -0,0 +1,43 @@
+#ifndef ACCOUNT_POLICY_H
+#define ACCOUNT_POLICY_H
+
+/**
+* Author: Group 13
+* Date: 28/3/2025
+*
+* @brief A header file that defines the compile-time policies used by every kind of account ("Account", "CheckingsAccount", and "SavingsAccount") to decide whether a withdrawal is allowed and how interest is calculated.
+*
+* AccountPolicy.h:
+* This is a header file that defines small policy structs that hold the rules of each account kind. Each account class calls its own policy from its own 'withdraw',
+* and 'AccountBatch' runs one loop per policy over many accounts of the same kind, where the rule is resolved at compile time and can be inlined by the compiler.
+*/
+
+struct StandardPolicy {
+    // A plain account only allows withdrawals that are within its balance
+    static bool allowsWithdrawal(double amount, double balance) {
+        return amount <= balance;
+    }
+};
+
+struct CheckingsPolicy {
+    double withdrawalLimit; // The Checkings Account's withdrawal limit
+
+    // A Checkings Account must also stay within its withdrawal limit
+    bool allowsWithdrawal(double amount, double balance) const {
+        return amount <= withdrawalLimit && amount <= balance;
+    }
+};
+
+struct SavingsPolicy {
+    // Savings Accounts withdraw like a plain account
+    static bool allowsWithdrawal(double amount, double balance) {
+        return StandardPolicy::allowsWithdrawal(amount, balance);
+    }
+
+    // The interest earned on a balance at the shared Savings interest rate
+    static double interest(double balance, double interestRate) {
+        return interestRate * balance;
+    }
+};
+
+#endif // ACCOUNT_POLICY_H
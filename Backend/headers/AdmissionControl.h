@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include "crow_all.h"
+#include "PriorityScheduler.h"
+
+/**
+ * @brief Crow middleware that sheds low-priority requests with 503 when the server falls behind.
+ *
+ * Requests are put in one of three classes by their scheduler priority: critical (transfers and
+ * holds), reads (user, account and balance reads) and bulk (history, exports, statements, ledger
+ * checks and static files). Two signals decide what gets in:
+ *
+ * - Queueing delay: how long handlers wait in the priority scheduler's queues before a worker
+ *   takes them. As in CoDel, the lowest delay seen over an interval is compared with a target.
+ *   Every interval it stays above the target raises the overload level by one; every interval
+ *   below lowers it. Level 1 sheds bulk work and level 2 also sheds reads. Transfers are never
+ *   shed by this signal.
+ * - A gradient concurrency limit on in-flight requests. It follows the ratio of the best recent
+ *   latency to the current latency, and each class may only use part of it (bulk half, reads
+ *   three quarters), so transfers always have headroom.
+ */
+class AdmissionControl {
+public:
+    enum class RouteClass : uint8_t { Critical, Read, Bulk };
+    static constexpr std::size_t kClasses = 3;
+
+    struct ClassStats {
+        uint64_t inFlight;
+        uint64_t admitted;
+        uint64_t shed;
+        uint64_t latencyMicros; // smoothed handler latency
+    };
+
+    struct Stats {
+        std::array<ClassStats, kClasses> classes;
+        uint64_t queueDelayMicros; // lowest scheduler queue delay in the last interval
+        int overloadLevel;
+        uint64_t concurrencyLimit;
+    };
+
+    struct context {
+        std::chrono::steady_clock::time_point start;
+        RouteClass routeClass = RouteClass::Read;
+        bool admitted = false;
+    };
+
+    AdmissionControl();
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    /**
+     * @brief Takes the queueing delay from the scheduler the handlers run on. Until this is called
+     * only the concurrency limit applies.
+     */
+    void watch(PriorityScheduler& scheduler);
+
+    /**
+     * @brief Sets the queueing delay target and the interval it is checked over.
+     */
+    void setTarget(std::chrono::milliseconds target, std::chrono::milliseconds interval);
+
+    Stats stats() const;
+
+    static RouteClass classify(const crow::request& req);
+
+private:
+    struct alignas(64) ClassState {
+        std::atomic<uint64_t> inFlight{ 0 };
+        std::atomic<uint64_t> admitted{ 0 };
+        std::atomic<uint64_t> shed{ 0 };
+        std::atomic<uint64_t> latencyMicros{ 0 };
+    };
+
+    void recordLatency(RouteClass routeClass, uint64_t micros);
+    void maybeAdvance(std::chrono::steady_clock::time_point now);
+    bool allowed(RouteClass routeClass, uint64_t inFlight) const;
+
+    std::array<ClassState, kClasses> classes;
+    std::atomic<uint64_t> totalInFlight{ 0 };
+    std::atomic<uint64_t> limit;
+
+    // CoDel state
+    PriorityScheduler* scheduler = nullptr;
+    std::atomic<uint64_t> lastMinDelay{ 0 };
+    std::atomic<int> overloadLevel{ 0 };
+
+    // latency samples for the gradient, collected over the current interval
+    std::atomic<uint64_t> intervalLatencySum{ 0 };
+    std::atomic<uint64_t> intervalLatencyCount{ 0 };
+    uint64_t bestLatency = 0; // guarded by advanceMutex
+
+    std::mutex advanceMutex;
+    std::atomic<int64_t> intervalEnd;
+    std::chrono::microseconds target{ 10000 };
+    std::chrono::microseconds interval{ 100000 };
+    std::chrono::steady_clock::time_point epoch;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+#include "AsyncLogger.h"
+#include "crow_all.h"
+
+/**
+ * @brief crow::ILogHandler that hands Crow's log lines to AsyncLogger instead of writing them to stderr.
+ *
+ * Install it with crow::logger::setHandler(); the handler must outlive the server.
+ */
+class AsyncLogHandler : public crow::ILogHandler {
+public:
+    void log(std::string message, crow::LogLevel level) override {
+        AsyncLogger::instance().logText(static_cast<AsyncLogger::Level>(level), message);
+    }
+};
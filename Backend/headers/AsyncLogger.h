@@ -0,0 +1,145 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Asynchronous structured logger with one lock-free ring per producing thread.
+ *
+ * log() copies a binary record (event name, up to four typed fields) into the calling
+ * thread's single-producer ring and returns; it never takes a lock or touches stdio after the
+ * thread's first record. A background thread drains every ring, formats the records as text
+ * and writes them in batches. When a ring is full the record is dropped and counted, and the
+ * flusher reports the number of dropped records.
+ */
+class AsyncLogger {
+public:
+    // Same order as crow::LogLevel so Crow's levels convert directly.
+    enum class Level : uint8_t { Debug, Info, Warning, Error, Critical };
+
+    static constexpr std::size_t kMaxFields = 4;
+    static constexpr std::size_t kMaxStringBytes = 46;
+    static constexpr std::size_t kRingCapacity = 1024; // records per thread, a power of two
+
+    /**
+     * @brief One key and value of a structured record.
+     *
+     * The key must be a string literal (only the pointer is stored); string values are copied
+     * and truncated to kMaxStringBytes.
+     */
+    class Field {
+    public:
+        Field(const char* key, int value) : Field(key, static_cast<long long>(value)) {}
+        Field(const char* key, long value) : Field(key, static_cast<long long>(value)) {}
+        Field(const char* key, long long value);
+        Field(const char* key, double value);
+        Field(const char* key, std::string_view value);
+        Field(const char* key, const char* value) : Field(key, std::string_view(value)) {}
+        Field(const char* key, const std::string& value) : Field(key, std::string_view(value)) {}
+
+    private:
+        friend class AsyncLogger;
+        enum class Type : uint8_t { Int, Double, String };
+
+        const char* key;
+        Type type;
+        uint8_t length = 0;
+        bool truncated = false;
+        union {
+            int64_t i;
+            double d;
+            char s[kMaxStringBytes];
+        } value;
+    };
+
+    /**
+     * @brief The process-wide logger; the flusher thread starts on first use.
+     */
+    static AsyncLogger& instance();
+
+    /**
+     * @brief Queues a structured record.
+     * @param level The severity.
+     * @param event A string literal naming the event, e.g. "user.load_failed".
+     * @param fields Up to kMaxFields key/value pairs; extra fields are ignored.
+     */
+    void log(Level level, const char* event, std::initializer_list<Field> fields = {});
+
+    /**
+     * @brief Queues an already formatted line, such as Crow's log output.
+     * @param level The severity.
+     * @param text The text; written as is and truncated to one record.
+     */
+    void logText(Level level, std::string_view text);
+
+    /**
+     * @brief Writes everything queued so far before returning.
+     */
+    void flush();
+
+    /**
+     * @brief Records dropped because a thread's ring was full.
+     */
+    uint64_t dropped() const;
+
+    /**
+     * @brief Sets the stream the flusher writes to; stderr by default.
+     */
+    void setOutput(FILE* output);
+
+    ~AsyncLogger();
+
+private:
+    struct Record {
+        int64_t timeNs;
+        const char* event;
+        Level level;
+        uint8_t fieldCount;
+        uint16_t textLength;
+        union {
+            Field fields[kMaxFields];
+            char text[kMaxFields * sizeof(Field)];
+        };
+        Record() {}
+    };
+
+    struct Ring {
+        alignas(64) std::atomic<uint64_t> head{ 0 }; // next record the flusher reads
+        alignas(64) std::atomic<uint64_t> tail{ 0 }; // next record the owner writes
+        alignas(64) std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<bool> orphaned{ false };         // owning thread has exited
+        Record records[kRingCapacity];
+    };
+
+    AsyncLogger();
+    Ring& threadRing();
+    Record* beginRecord(Ring*& ring);
+    static void commitRecord(Ring* ring);
+    void run();
+    bool drain();
+    void format(const Record& record);
+
+    mutable std::mutex ringsMutex; // guards rings; taken once per thread and by the flusher
+    std::vector<std::shared_ptr<Ring>> rings;
+    uint64_t retiredDrops = 0; // drops of rings already removed; guarded by ringsMutex
+    std::mutex drainMutex; // one consumer at a time
+    std::string out;
+    uint64_t reportedDrops = 0;
+    int64_t cachedSecond = -1;
+    char cachedTime[32] = {};
+    FILE* output = stderr;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread flusher;
+};
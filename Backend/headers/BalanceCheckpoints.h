@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "ShardedMap.h"
+#include "Transaction.h"
+
+/**
+ * @brief Periodic running-balance checkpoints per account, for history rows without a stored balance.
+ *
+ * Committed transactions carry the account balance after them (Transaction::balanceAfter), so a
+ * page of history already has its balances. Rows written before that field existed do not.
+ * fill() computes their balances from the newest checkpoint below the page. It replays only the
+ * rows between that checkpoint and the page, then takes a prefix sum over the page. A row that
+ * has its balance keeps it, and the sum carries on from there.
+ *
+ * Checkpoints are taken every kInterval commits of an account. fill() also leaves one every
+ * kInterval rows it replays and one at the end of each page it fills. The first fill of an old
+ * history replays it once; after that a page is filled in O(page + kInterval), and walking the
+ * history page by page replays nothing.
+ */
+class BalanceCheckpoints {
+public:
+    static constexpr std::size_t kInterval = 1000;
+
+    /**
+     * @brief Reads up to `limit` transactions of an account with IDs above `afterTransactionID`, in ID order.
+     */
+    using PageReader = std::function<std::vector<Transaction>(int accountID, int afterTransactionID, std::size_t limit)>;
+
+    struct Checkpoint {
+        int transactionID; // the last transaction included
+        double balance;    // the balance after it
+    };
+
+    static BalanceCheckpoints& instance();
+
+    BalanceCheckpoints(const BalanceCheckpoints&) = delete;
+    BalanceCheckpoints& operator=(const BalanceCheckpoints&) = delete;
+
+    /**
+     * @brief Counts a committed transaction, which already has its balance, and checkpoints every kInterval-th.
+     */
+    void record(const Transaction& transaction);
+
+    /**
+     * @brief Sets balanceAfter on every row of a page of one account's history that has none.
+     * @param accountID The account.
+     * @param afterTransactionID The ID the page was read after.
+     * @param page Consecutive rows of the history in transaction ID order.
+     * @param reader Reads the rows between the checkpoint and the page, with missing balances left missing.
+     */
+    void fill(int accountID, int afterTransactionID, std::vector<Transaction>& page, const PageReader& reader);
+
+private:
+    struct Track {
+        std::mutex mutex;
+        std::size_t committed = 0;
+        std::vector<Checkpoint> checkpoints; // sorted by transactionID
+    };
+
+    BalanceCheckpoints() = default;
+
+    static void add(Track& track, const Checkpoint& checkpoint);
+
+    ShardedMap<int, Track> tracks;
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ShardedMap.h"
+
+namespace crow {
+    namespace websocket {
+        struct connection;
+    }
+}
+
+/**
+ * @brief In-process publish/subscribe bus for account balance changes, pushed to WebSocket clients.
+ *
+ * A balance change is published once it is committed: by a route after it saves the accounts,
+ * and by the hold ledger after it settles. Each WebSocket connection subscribes to the accounts it
+ * watches; a change is recorded in the connection's pending set, where a later change to the same
+ * account replaces the earlier one. A flusher thread wakes every flush interval and, on each
+ * connection's own io_service thread, sends everything pending as one frame:
+ *
+ *     {"type":"balances","updates":[{"accountID":1,"balance":120.5,"sequence":42}]}
+ *
+ * A connection whose unsent output is above the queue limit is skipped until it drains, so a slow
+ * client costs one pending entry per watched account rather than a growing backlog of frames.
+ *
+ * Clients send `{"subscribe":<accountID>}` or `{"unsubscribe":<accountID>}` as text messages.
+ */
+class BalanceFeed {
+public:
+    struct Stats {
+        uint64_t connections;
+        uint64_t published;  // balance changes published
+        uint64_t delivered;  // updates sent to clients
+        uint64_t coalesced;  // updates replaced by a newer one before they were sent
+        uint64_t frames;
+        uint64_t deferred;   // flushes put off because the client was behind
+    };
+
+    /**
+     * @brief The process-wide feed; the flusher thread starts on first use.
+     */
+    static BalanceFeed& instance();
+
+    ~BalanceFeed();
+
+    BalanceFeed(const BalanceFeed&) = delete;
+    BalanceFeed& operator=(const BalanceFeed&) = delete;
+
+    /**
+     * @brief Publishes an account's new balance to its subscribers; cheap when nobody is subscribed.
+     * @param accountID The account.
+     * @param balance The balance after the change.
+     */
+    void publish(int accountID, double balance);
+
+    /**
+     * @brief Adds an in-process listener that publish() calls on the publishing thread.
+     *
+     * Listeners are read without a lock, so register them all before the server starts.
+     */
+    void listen(std::function<void(int accountID, double balance)> listener);
+
+    /**
+     * @brief Registers a WebSocket connection; call from its onopen handler.
+     */
+    void open(crow::websocket::connection& conn);
+
+    /**
+     * @brief Handles a subscribe or unsubscribe message; call from the onmessage handler.
+     */
+    void message(crow::websocket::connection& conn, std::string_view text);
+
+    /**
+     * @brief Drops the connection's subscriptions; call from the onclose handler.
+     */
+    void close(crow::websocket::connection& conn);
+
+    /**
+     * @brief Stops the flusher thread; call before the server's io_services are destroyed.
+     */
+    void stop();
+
+    /**
+     * @brief Sets how often pending updates are sent and how much unsent output a connection may have.
+     */
+    void setLimits(std::chrono::milliseconds flushInterval, std::size_t maxQueuedBytes);
+
+    Stats stats() const;
+
+private:
+    struct Update {
+        double balance;
+        uint64_t sequence;
+    };
+
+    struct Subscriber; // defined in BalanceFeed.cpp, next to the Crow types it holds
+
+    static constexpr std::size_t kMaxAccountsPerConnection = 64;
+
+    using Topics = ShardedMap<int, std::vector<std::shared_ptr<Subscriber>>>;
+
+    BalanceFeed();
+
+    void subscribe(const std::shared_ptr<Subscriber>& subscriber, int accountID);
+    void unsubscribe(const std::shared_ptr<Subscriber>& subscriber, int accountID);
+    void schedule(const std::shared_ptr<Subscriber>& subscriber);
+    void flush(const std::shared_ptr<Subscriber>& subscriber);
+    void run();
+
+    Topics topics; // subscribers per account; erased when the last one leaves, so used under the shard lock
+    std::vector<std::function<void(int, double)>> listeners;
+    std::atomic<uint64_t> subscriptions{ 0 };
+    std::atomic<uint64_t> sequence{ 0 };
+
+    std::atomic<uint64_t> connections{ 0 };
+    std::atomic<uint64_t> published{ 0 };
+    std::atomic<uint64_t> delivered{ 0 };
+    std::atomic<uint64_t> coalesced{ 0 };
+    std::atomic<uint64_t> frames{ 0 };
+    std::atomic<uint64_t> deferred{ 0 };
+
+    std::atomic<int64_t> flushIntervalMs{ 25 };
+    std::atomic<std::size_t> maxQueuedBytes{ 256 * 1024 };
+
+    std::mutex dirtyMutex;
+    std::condition_variable dirtyReady;
+    std::vector<std::shared_ptr<Subscriber>> dirty;
+    bool stopping = false;
+    std::thread flusher;
+};
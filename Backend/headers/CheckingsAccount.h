@@ -23,6 +23,7 @@ public:
     void withdraw(double amount) override;  // A withdraw function that overrides the withdraw function in the 'Account' class since it should now check if the withdrawal amount exceeds the Checkings Account's withdrawal limit
     double getWithdrawalLimit() const; // A getter function that returns the Checkings Account's withdrawal limit
     void setWithdrawalLimit(double newLimit); // A setter function that sets the Checkings Account's withdrawal limit to a new/different value
+    CheckingsPolicy getPolicy() const; // A getter function that returns the withdrawal policy built from the Checkings Account's withdrawal limit
 
 private:
     double withdrawalLimit; // The withdrawal limit
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ShardedMap.h"
+
+/**
+ * @brief Pending holds (authorisations) per account, with ledger and available balances kept in memory.
+ *
+ * Each account has a small book: its ledger balance, the total held, and its live holds in a
+ * compact vector. The available balance is the ledger balance minus the total held, so it costs
+ * O(1). Both balances are read without touching storage. The ledger balance follows every
+ * balance published through BalanceFeed; main() wires that up with setBalance().
+ *
+ * A hold ID carries its account ID in the high 32 bits, so releasing or settling a hold goes
+ * straight to its account's book.
+ *
+ * Holds that are neither settled nor released expire. The expiry thread turns a hashed timer
+ * wheel of kWheelSlots one-second slots. A slot lists hold IDs only; a hold released before its
+ * slot comes round is skipped then, so releasing a hold never touches the wheel. Holds more than
+ * one turn away stay in their slot until their time.
+ *
+ * settle() turns holds into postings in batches. Settlements are grouped by account, each book is
+ * locked once per batch, and each account's settled total goes to the journal as one entry.
+ */
+class HoldLedger {
+public:
+    static constexpr std::size_t kWheelSlots = 4096;
+    static constexpr std::chrono::seconds kDefaultTtl{ 7 * 24 * 60 * 60 };
+
+    struct Balances {
+        bool known = false;  // false until the account's balance has been seen
+        double ledger = 0.0; // posted balance
+        double held = 0.0;   // sum of live holds
+        double available = 0.0;
+        std::size_t holds = 0;
+    };
+
+    struct Settlement {
+        uint64_t holdID;
+        double amount; // the amount posted: more than zero and at most the amount held
+    };
+
+    struct Posting {
+        uint64_t holdID;
+        int accountID;
+        bool settled;        // false if the hold had expired or was released, or the amount was out of range
+        double balanceAfter; // the ledger balance after the posting
+    };
+
+    static HoldLedger& instance();
+
+    HoldLedger(const HoldLedger&) = delete;
+    HoldLedger& operator=(const HoldLedger&) = delete;
+    ~HoldLedger();
+
+    static int accountOf(uint64_t holdID) { return static_cast<int>(static_cast<uint32_t>(holdID >> 32)); }
+
+    /**
+     * @brief Sets an account's ledger balance; the BalanceFeed listener calls this on every change.
+     */
+    void setBalance(int accountID, double balance);
+
+    /**
+     * @brief Sets an account's ledger balance only if none is known yet, e.g. from storage on first use.
+     */
+    void seedBalance(int accountID, double balance);
+
+    /**
+     * @brief Places a hold if the available balance covers it.
+     * @param accountID The account.
+     * @param amount The amount to hold; must be at least a cent.
+     * @param ttl How long the hold lives unless settled or released.
+     * @return The hold ID, or 0 if the balance is unknown or the available balance is too low.
+     */
+    uint64_t place(int accountID, double amount, std::chrono::seconds ttl = kDefaultTtl);
+
+    /**
+     * @brief Releases a hold without posting it.
+     * @return False if the hold does not exist (already settled, released or expired).
+     */
+    bool release(uint64_t holdID);
+
+    /**
+     * @brief The amount a hold reserves, or 0 if it does not exist.
+     */
+    double heldAmount(uint64_t holdID);
+
+    /**
+     * @brief Posts a batch of holds. A settlement for zero, less, or more than its hold reserves
+     * is not posted, and its hold stays in place.
+     * @return One posting per settlement, in the order given.
+     * @throws std::runtime_error If no transaction IDs could be taken; nothing is settled then.
+     */
+    std::vector<Posting> settle(const std::vector<Settlement>& batch);
+
+    /**
+     * @brief The account's balances; an account never seen is returned as unknown and not added.
+     */
+    Balances balances(int accountID);
+
+    /**
+     * @brief Stops the expiry thread.
+     */
+    void stop();
+
+private:
+    struct Hold {
+        uint32_t sequence;
+        double amount;
+        int64_t expiresAt; // wheel tick
+    };
+
+    struct Book {
+        std::mutex mutex;
+        bool known = false;
+        double balance = 0.0;
+        double held = 0.0;
+        uint32_t nextSequence = 1;
+        std::vector<Hold> holds;
+    };
+
+    HoldLedger();
+
+    static std::vector<Hold>::iterator findHold(Book& book, uint64_t holdID);
+    static void removeHold(Book& book, std::vector<Hold>::iterator hold);
+    int64_t now() const;
+    void schedule(uint64_t holdID, int64_t expiresAt);
+    void run();
+    void expire(std::vector<uint64_t>& due, int64_t tick);
+
+    ShardedMap<int, Book> books;
+
+    const std::chrono::steady_clock::time_point epoch;
+    std::mutex wheelMutex;
+    std::vector<std::vector<uint64_t>> wheel;
+    int64_t turnedTo = 0; // the last tick whose slot has been processed
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread expirer;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Double-entry journal under every account balance.
+ *
+ * Every money movement is an entry of two or more legs, each crediting (+) or debiting (-) one
+ * account in integer cents. An entry is only accepted if its legs sum to exactly zero. Money
+ * that enters or leaves the bank goes through kExternalAccount, so deposits and withdrawals
+ * balance too. The first time an account is seen, its stored balance is brought in once with an
+ * opening entry against kOpeningEquityAccount.
+ *
+ * Account balances are projections of the journal: the sum of every leg on the account, kept
+ * up to date as entries are appended. post() checks funds against the projection inside the
+ * commit, so the check and the posting are atomic.
+ *
+ * Commits are grouped. Callers that post while a commit is running queue their entries; the
+ * next commit appends the whole queue under one lock. Under load, many entries share each
+ * commit, and a durable journal would write them in one I/O. A caller commits at most one batch:
+ * if more entries queued meanwhile, it hands the next commit to the first of their callers, so
+ * no post() waits on a stream of other callers' work.
+ *
+ * verify() re-derives every balance from the journal on several threads and compares them with
+ * the projections at the same point in the journal.
+ */
+class Journal {
+public:
+    static constexpr int kExternalAccount = -1;
+    static constexpr int kOpeningEquityAccount = -2;
+
+    struct Leg {
+        int accountID;
+        int64_t cents; // positive credits the account, negative debits it
+    };
+
+    struct Entry {
+        std::vector<Leg> legs;
+        bool allowOverdraft = false; // otherwise no customer account may go below zero
+    };
+
+    struct Mismatch {
+        int accountID;
+        int64_t journalCents;    // re-derived from the legs
+        int64_t projectionCents; // what balance() reported
+    };
+
+    struct VerifyResult {
+        bool ok = false;
+        uint64_t entries = 0;
+        uint64_t legs = 0;
+        std::size_t accounts = 0;
+        uint64_t unbalancedEntries = 0;
+        std::vector<Mismatch> mismatches; // at most kMaxReportedMismatches
+        double seconds = 0.0;
+    };
+
+    static constexpr std::size_t kMaxReportedMismatches = 100;
+
+    static Journal& instance();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    static int64_t toCents(double amount);
+    static double fromCents(int64_t cents);
+
+    /**
+     * @brief Entries that move `amount` between two accounts, or in or out of the bank.
+     * @throws std::invalid_argument If the amount is not a positive number of cents.
+     */
+    static Entry transfer(int fromAccountID, int toAccountID, double amount);
+    static Entry deposit(int accountID, double amount);
+    static Entry withdrawal(int accountID, double amount);
+
+    /**
+     * @brief Brings an account's stored balance into the journal the first time it is seen.
+     */
+    void open(int accountID, double balance);
+
+    /**
+     * @brief Appends an entry and updates the projections of its accounts.
+     * @return The entry's sequence number, or 0 if it would overdraw an account.
+     * @throws std::invalid_argument If the entry has fewer than two legs, has a leg of zero cents,
+     *         or does not balance.
+     */
+    uint64_t post(Entry entry);
+
+    double balance(int accountID);
+
+    /**
+     * @brief Re-derives every balance from the journal and compares it with its projection.
+     * @param threads Worker count; 0 uses one per hardware thread.
+     */
+    VerifyResult verify(std::size_t threads = 0);
+
+private:
+    static constexpr std::size_t kChunkSize = 1 << 16;
+
+    // Legs live in fixed-size chunks that never move, so the verifier reads them without the lock.
+    struct LegChunk {
+        Leg legs[kChunkSize];
+    };
+
+    struct EntrySpan {
+        uint64_t firstLeg;
+        uint32_t legCount;
+    };
+
+    struct EntryChunk {
+        EntrySpan entries[kChunkSize];
+    };
+
+    struct Request {
+        Entry entry;
+        uint64_t sequence = 0;
+        bool done = false;
+        bool leads = false; // handed the next commit
+    };
+
+    Journal() = default;
+
+    static void check(const Entry& entry);
+    void commit(std::vector<Request*>& batch);
+    uint64_t append(const Entry& entry);
+
+    // group commit
+    std::mutex queueMutex;
+    std::condition_variable committed;
+    std::vector<Request*> queue;
+    bool committing = false;
+
+    // the journal and its projections
+    std::mutex journalMutex;
+    std::vector<std::unique_ptr<LegChunk>> legChunks;
+    std::vector<std::unique_ptr<EntryChunk>> entryChunks;
+    uint64_t legCount = 0;
+    uint64_t entryCount = 0;
+    std::unordered_map<int, int64_t> projections;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Validating JSON scanner that reads fields on demand instead of building a tree.
+ *
+ * parse() runs in two stages. Stage one classifies the input 16 bytes at a time (SSE2 where
+ * available) and records the offset of every quote and structural character that is not
+ * inside a string. Stage two walks that index once to check the grammar, UTF-8 and number
+ * syntax, and remembers where each top-level member of the root object starts. Getters then
+ * decode only the fields that are asked for.
+ *
+ * A JsonIndex keeps its buffers between calls, so reusing one instance per thread makes
+ * parsing allocation-free once the buffers have grown. An index built on a request's arena
+ * allocates them there instead, and they are freed with the rest of the request.
+ */
+class JsonIndex {
+public:
+    /**
+     * @param resource Where the index's buffers are allocated; nullptr uses the default resource.
+     */
+    explicit JsonIndex(std::pmr::memory_resource* resource = nullptr);
+
+    /**
+     * @brief Indexes and validates a JSON document whose root is an object.
+     * @param json The document; it must outlive the index until the next parse().
+     * @return True if the document is valid JSON with an object at the root.
+     */
+    bool parse(std::string_view json);
+
+    /**
+     * @brief Reads a top-level string member, decoding escapes.
+     * @param key The member name.
+     * @param out Receives the decoded value.
+     * @return True if the member exists and is a string.
+     */
+    bool getString(std::string_view key, std::string& out) const;
+
+    /**
+     * @brief Reads a top-level number member.
+     * @param key The member name.
+     * @param out Receives the value.
+     * @return True if the member exists and is a number that fits in a double.
+     */
+    bool getDouble(std::string_view key, double& out) const;
+
+    /**
+     * @brief Checks whether the root object has a member, whatever its type.
+     * @param key The member name.
+     */
+    bool has(std::string_view key) const;
+
+    /**
+     * @brief Splits a top-level array member into the raw text of its elements.
+     * @param key The member name.
+     * @param out Receives one view per element, into the parsed document; an object element can
+     *            be read with parse() on another index.
+     * @return True if the member exists and is an array.
+     */
+    bool getElements(std::string_view key, std::pmr::vector<std::string_view>& out) const;
+
+private:
+    enum class Kind : uint8_t { String, Number, Literal, Object, Array };
+
+    struct Member {
+        uint32_t keyBegin;
+        uint32_t keyEnd;
+        uint32_t valueBegin;
+        uint32_t valueEnd;
+        Kind kind;
+    };
+
+    void buildIndex();
+    bool parseValue(size_t& token, size_t& cursor, int depth, Member* member);
+    bool parseContainer(size_t& token, size_t& cursor, int depth, char close);
+    bool expect(size_t& token, size_t& cursor, char c);
+    const Member* find(std::string_view key) const;
+
+    std::string_view json;
+    std::pmr::vector<uint32_t> tokens;
+    std::pmr::vector<Member> members;
+    bool unterminatedString = false;
+};
+
+/**
+ * @brief The body of a POST /api/transfer request.
+ */
+struct TransferRequest {
+    std::string senderId;
+    std::string recipientId;
+    double amount = 0.0;
+
+    /**
+     * @brief Extracts senderId, recipientId and amount from a request body.
+     * @param body The raw JSON body.
+     * @param out Receives the fields.
+     * @param scratch The request's arena for the index, or nullptr to reuse this thread's index.
+     * @return False if the body is not valid JSON or a field is missing or has the wrong type.
+     */
+    static bool parse(std::string_view body, TransferRequest& out, std::pmr::memory_resource* scratch = nullptr);
+};
+
+/**
+ * @brief The body of a POST /api/accounts/<id>/holds request.
+ */
+struct HoldRequest {
+    double amount = 0.0;
+    double ttlSeconds = 0.0; // 0 when the body leaves it out
+
+    /**
+     * @brief Extracts amount and the optional ttlSeconds from a request body.
+     * @param body The raw JSON body.
+     * @param out Receives the fields.
+     * @param scratch The request's arena for the index, or nullptr to reuse this thread's index.
+     * @return False if the body is not valid JSON, amount is missing, or a field has the wrong type.
+     */
+    static bool parse(std::string_view body, HoldRequest& out, std::pmr::memory_resource* scratch = nullptr);
+};
+
+/**
+ * @brief The body of a POST /api/holds/settle request.
+ */
+struct SettleRequest {
+    struct Settlement {
+        std::string holdID;
+        double amount = 0.0;
+    };
+
+    std::vector<Settlement> settlements;
+
+    /**
+     * @brief Extracts the settlements array and each element's holdID and amount.
+     * @param body The raw JSON body.
+     * @param out Receives the settlements.
+     * @param scratch The request's arena for the indexes, or nullptr to reuse this thread's.
+     * @return False if the body is not valid JSON, settlements is missing, or an element is not an
+     *         object with a string holdID and a number amount.
+     */
+    static bool parse(std::string_view body, SettleRequest& out, std::pmr::memory_resource* scratch = nullptr);
+};
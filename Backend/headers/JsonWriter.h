@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @brief Writes JSON text straight into a caller-owned buffer.
+ *
+ * There is no intermediate tree: every call appends to the buffer, and commas are tracked
+ * with one bit per nesting level (up to 64 levels). Members are written in the order
+ * they are given, so nothing is sorted or copied again afterwards.
+ *
+ * The buffer is a std::string (JsonWriter) or a std::pmr::string (ArenaJsonWriter), so a
+ * response body can be written in the request's arena; both are instantiated in JsonWriter.cpp.
+ */
+template <typename String>
+class BasicJsonWriter {
+public:
+    explicit BasicJsonWriter(String& out) : out(out) {}
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    /**
+     * @brief Writes a member name; the next value call writes its value.
+     * @param name The member name, escaped as needed.
+     */
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text) { value(std::string_view(text)); }
+    void value(const std::string& text) { value(std::string_view(text)); }
+    void value(bool flag);
+    void value(int number) { value(static_cast<int64_t>(number)); }
+    void value(int64_t number);
+    void value(double number);
+    void null();
+
+    /**
+     * @brief Appends an already-serialised JSON value without checking it.
+     * @param json The JSON text.
+     */
+    void raw(std::string_view json);
+
+    String& buffer() { return out; }
+
+private:
+    void separate();
+    static void appendEscaped(String& out, std::string_view text);
+
+    String& out;
+    uint64_t hasMembers = 0; // bit d is set once the container at depth d has a value
+    int depth = 0;
+    bool afterKey = false;
+};
+
+using JsonWriter = BasicJsonWriter<std::string>;
+using ArenaJsonWriter = BasicJsonWriter<std::pmr::string>;
+
+extern template class BasicJsonWriter<std::string>;
+extern template class BasicJsonWriter<std::pmr::string>;
+
+/**
+ * @brief One serialised member of a model: its JSON name and a pointer to the data member.
+ */
+template <typename Model, typename Member>
+struct JsonField {
+    const char* name;
+    Member Model::* member;
+};
+
+template <typename Model, typename Member>
+constexpr JsonField<Model, Member> jsonField(const char* name, Member Model::* member) {
+    return JsonField<Model, Member>{ name, member };
+}
+
+/**
+ * @brief Compile-time description of a model's JSON form.
+ *
+ * Each specialisation provides `static constexpr auto fields`, a tuple of jsonField()
+ * entries. Models declare the specialisation a friend so it can point at private members.
+ */
+template <typename T>
+struct JsonFields;
+
+/**
+ * @brief Serialises a described model as one JSON object.
+ * @param writer The writer to append to.
+ * @param model The model to serialise.
+ */
+template <typename String, typename T>
+void writeJson(BasicJsonWriter<String>& writer, const T& model) {
+    writer.beginObject();
+    std::apply([&](const auto&... field) {
+        ((writer.key(field.name), writer.value(model.*(field.member))), ...);
+    }, JsonFields<T>::fields);
+    writer.endObject();
+}
+
+/**
+ * @brief Serialises a described model into a new string.
+ * @param model The model to serialise.
+ * @return The JSON text.
+ */
+template <typename T>
+std::string toJsonString(const T& model) {
+    std::string out;
+    out.reserve(128);
+    JsonWriter writer(out);
+    writeJson(writer, model);
+    return out;
+}
+
+/**
+ * @brief Builds a chunk source that streams a JSON array of models.
+ *
+ * The returned function is meant for crow::response::stream(). Each call appends whole
+ * elements to the chunk until it holds at least `chunkBytes`, so memory use is bounded by
+ * one chunk no matter how many elements there are.
+ *
+ * @param next Called as `const T* next()`; returns the next element, or nullptr at the end.
+ *             The element only has to stay valid until the following call.
+ * @param chunkBytes Target size of each chunk.
+ * @return A function that fills the next chunk and returns false after the last one.
+ */
+template <typename Next>
+std::function<bool(std::string&)> streamJsonArray(Next next, std::size_t chunkBytes = 16 * 1024) {
+    struct State {
+        Next next;
+        bool started = false;
+        bool first = true;
+    };
+    auto state = std::make_shared<State>(State{ std::move(next), false, true });
+
+    return [state, chunkBytes](std::string& chunk) {
+        if (!state->started) {
+            state->started = true;
+            chunk += '[';
+        }
+        while (chunk.size() < chunkBytes) {
+            const auto* item = state->next();
+            if (!item) {
+                chunk += ']';
+                return false;
+            }
+            if (!state->first) {
+                chunk += ',';
+            }
+            state->first = false;
+            JsonWriter writer(chunk);
+            writeJson(writer, *item);
+        }
+        return true;
+    };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "JsonWriter.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "User.h"
+
+/**
+ * @brief JSON field descriptions for the backend models.
+ * @details Members are written in the order listed here.
+ */
+template <>
+struct JsonFields<User> {
+    // The card number is deliberately left out of API responses
+    static constexpr auto fields = std::make_tuple(
+        jsonField("userID", &User::userID),
+        jsonField("username", &User::username));
+};
+
+template <>
+struct JsonFields<Account> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("accountID", &Account::accountID),
+        jsonField("balance", &Account::balance),
+        jsonField("userID", &Account::userID),
+        jsonField("accountType", &Account::accountType));
+};
+
+template <>
+struct JsonFields<Transaction> {
+    static constexpr auto fields = std::make_tuple(
+        jsonField("transactionID", &Transaction::transactionID),
+        jsonField("accountID", &Transaction::accountID),
+        jsonField("transactionType", &Transaction::transactionType),
+        jsonField("amount", &Transaction::amount),
+        jsonField("date", &Transaction::date),
+        jsonField("balanceAfter", &Transaction::balanceAfter));
+};
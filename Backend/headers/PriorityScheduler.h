@@ -0,0 +1,122 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crow_all.h"
+
+/**
+ * @brief Worker pool that runs route handlers off the io_service threads, by priority.
+ *
+ * Each worker owns one queue per priority. Workers pick work by weighted round robin (8:4:2:1 for
+ * transfers, account reads, history and static files), so money movement gets most of the pool
+ * under load while static files still make progress. A worker with nothing queued steals from the
+ * others with the same weights before it sleeps.
+ *
+ * A request's priority comes from one route table (routePriority), which admission control also
+ * reads to class the request, so the two cannot disagree. Workers also time how long each task
+ * waited in its queue; admission control sheds load on that delay.
+ */
+class PriorityScheduler {
+public:
+    enum class Priority : uint8_t { Transfer, AccountRead, History, Static };
+    static constexpr std::size_t kPriorities = 4;
+
+    explicit PriorityScheduler(unsigned threads = std::thread::hardware_concurrency());
+    ~PriorityScheduler();
+
+    PriorityScheduler(const PriorityScheduler&) = delete;
+    PriorityScheduler& operator=(const PriorityScheduler&) = delete;
+
+    /**
+     * @brief Queues a task; it runs on one of the pool's threads.
+     * @param priority The task's queue.
+     * @param task The work to run.
+     */
+    void submit(Priority priority, std::function<void()> task);
+
+    /**
+     * @brief The priority of a request, from the route table; API routes not in it are account reads
+     * and everything else is static.
+     */
+    static Priority routePriority(const crow::request& req);
+
+    /**
+     * @brief The shortest time a task waited in its queue since the last call, in microseconds.
+     *
+     * If no task was taken since then but some are queued, they have all waited at least since the
+     * last call, so that time is returned. 0 if the queues were empty throughout.
+     */
+    uint64_t takeQueueDelay();
+
+    /**
+     * @brief Runs a handler on the pool, at its route's priority, and completes the Crow response with its result.
+     *
+     * The response is handed back to the connection's io_service before res.end(), because
+     * crow::Connection is only safe to touch from its own thread. Exceptions become a 500.
+     *
+     * @param req The request; its io_service receives the completion.
+     * @param res The response to complete.
+     * @param handler Called as `crow::response handler()` on a pool thread.
+     */
+    template <typename Handler>
+    void dispatch(const crow::request& req, crow::response& res, Handler handler);
+
+private:
+    struct Task {
+        std::function<void()> run;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::array<std::deque<Task>, kPriorities> queues;
+    };
+
+    void run(std::size_t self);
+    bool take(Worker& worker, std::size_t& slot, Task& task, bool steal);
+    void recordDelay(std::chrono::steady_clock::duration delay);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> nextWorker{ 0 };
+    std::atomic<std::size_t> queued{ 0 };
+
+    // shortest queue wait since the last takeQueueDelay(), and when that was; microseconds since epoch
+    std::atomic<uint64_t> minDelay;
+    std::atomic<int64_t> lastDelaySample{ 0 };
+    const std::chrono::steady_clock::time_point epoch;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+template <typename Handler>
+void PriorityScheduler::dispatch(const crow::request& req, crow::response& res, Handler handler) {
+    boost::asio::io_service* io = req.io_service;
+    submit(routePriority(req), [io, &res, handler = std::move(handler)]() mutable {
+        auto result = std::make_shared<crow::response>();
+        try {
+            *result = handler();
+        } catch (const std::exception& e) {
+            CROW_LOG_ERROR << "Handler failed on the scheduler: " << e.what();
+            *result = crow::response(500);
+        }
+        io->post([&res, result] {
+            res = std::move(*result);
+            res.end();
+        });
+    });
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "crow_all.h"
+
+/**
+ * @brief Crow middleware that rejects API requests over a per-client rate with 429.
+ *
+ * Every /api/ request spends a token from its client IP's bucket. Requests carry no authenticated
+ * identity, so the limiter never keys on a user ID taken from the path or body: anyone could name
+ * a victim's ID and drain that user's bucket. The check runs in before_handle, ahead of the other
+ * middlewares and of any database access, and costs a hash, a short probe and one
+ * compare-and-swap.
+ */
+class RateLimiter {
+public:
+    /**
+     * @brief A token-bucket rate: tokens added per second and the most a bucket can hold.
+     */
+    struct Limit {
+        double perSecond;
+        double burst;
+    };
+
+    /**
+     * @brief Lock-free table of token buckets keyed by a 64-bit hash.
+     *
+     * Slots are open-addressed with a short linear probe. Each bucket is one atomic word holding
+     * its token count (in 1/256 tokens) and the time of its last refill, so spending a token is a
+     * single compare-and-swap. A bucket that has been idle long enough to refill completely is
+     * indistinguishable from a new one, so its slot is handed to the next new key.
+     */
+    class BucketTable {
+    public:
+        explicit BucketTable(std::size_t slots);
+
+        /**
+         * @brief Takes one token from the key's bucket.
+         * @param key The hashed key; 0 is remapped internally.
+         * @param limit The rate and burst for this bucket.
+         * @param nowMs Milliseconds since the limiter started.
+         * @return False if the bucket is empty. A key that finds no free slot is allowed.
+         */
+        bool tryAcquire(uint64_t key, const Limit& limit, uint64_t nowMs);
+
+    private:
+        struct alignas(16) Slot {
+            std::atomic<uint64_t> key{ 0 };
+            std::atomic<uint64_t> state{ 0 }; // refill time in ms << 24 | tokens * 256; 0 = full
+        };
+
+        static constexpr int kProbe = 8;
+
+        std::unique_ptr<Slot[]> slots;
+        std::size_t mask;
+    };
+
+    struct context {};
+
+    RateLimiter();
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx);
+    void after_handle(crow::request& req, crow::response& res, context& ctx);
+
+    void setIpLimit(Limit limit);
+
+    /**
+     * @brief Gets the number of requests rejected since startup.
+     */
+    static uint64_t rejected();
+
+private:
+    uint64_t nowMs() const;
+
+    Limit ipLimit{ 20.0, 40.0 };
+    BucketTable ipBuckets;
+    std::chrono::steady_clock::time_point start;
+
+    static std::atomic<uint64_t> rejectedCount;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Transaction.h"
+
+/**
+ * @brief Checks every stored account balance against the sum of the account's transactions.
+ *
+ * The transaction set is read once, page by page in transaction ID order, on the calling thread.
+ * Worker threads aggregate the pages while the next one is read. Each worker keeps its own sums,
+ * split into one partition per worker by account ID, so aggregation takes no locks. Then worker
+ * p merges partition p from every worker and compares it with the stored balances of the same
+ * accounts.
+ *
+ * Sums are kept in integer cents, so they are exact however many transactions an account has
+ * and in whatever order they are added. A stored balance matches if it rounds to the same cents.
+ */
+class Reconciler {
+public:
+    /**
+     * @brief Reads up to `limit` transactions of all accounts with IDs above `afterTransactionID`, in ID order.
+     */
+    using ScanReader = std::function<std::vector<Transaction>(int afterTransactionID, std::size_t limit)>;
+
+    struct StoredBalance {
+        int accountID;
+        double balance;
+    };
+
+    struct Mismatch {
+        int accountID;
+        bool stored;          // false if the account has transactions but no stored balance
+        int64_t storedCents;
+        int64_t historyCents; // the sum of the account's transaction amounts
+        uint64_t transactions;
+    };
+
+    struct Report {
+        uint64_t transactions = 0;
+        std::size_t pages = 0;
+        std::size_t accounts = 0;          // accounts with a stored balance, transactions, or both
+        std::vector<Mismatch> mismatches;  // in account ID order
+        double seconds = 0.0;
+        double transactionsPerSecond = 0.0;
+    };
+
+    static constexpr std::size_t kPageSize = 5000;
+
+    /**
+     * @brief Reconciles the stored balances against the whole transaction set.
+     * @param reader Reads one page; Transaction::getAllTransactionsPage in production.
+     * @param balances The stored balance of every account.
+     * @param threads Worker count; 0 uses one per hardware thread.
+     * @throws std::exception If a page read fails.
+     */
+    static Report run(const ScanReader& reader, const std::vector<StoredBalance>& balances, std::size_t threads = 0,
+                      std::size_t pageSize = kPageSize);
+
+    /**
+     * @brief Writes the mismatches as CSV: accountID, storedBalance, historyBalance, difference, transactions.
+     */
+    static void writeCsv(const Report& report, std::ostream& out);
+};
+
+/**
+ * @brief Runs the reconciliation once a night on its own thread and writes each report to a file.
+ *
+ * Reports go to `reconciliation-YYYY-MM-DD.csv` in the job's directory, dated in UTC. A run that
+ * fails is logged and not retried until the next night; runOnce() reruns it by hand.
+ */
+class NightlyReconciliation {
+public:
+    /**
+     * @brief Reads the stored balance of every account, at the time of the run.
+     */
+    using BalanceReader = std::function<std::vector<Reconciler::StoredBalance>()>;
+
+    /**
+     * @brief Starts the job; the first run is at the next `hourUtc`.
+     * @param directory Created on the first run if it does not exist.
+     */
+    NightlyReconciliation(Reconciler::ScanReader reader, BalanceReader balances, std::string directory, int hourUtc = 2);
+    ~NightlyReconciliation();
+
+    NightlyReconciliation(const NightlyReconciliation&) = delete;
+    NightlyReconciliation& operator=(const NightlyReconciliation&) = delete;
+
+    /**
+     * @brief Reconciles now and writes the report, on the calling thread.
+     * @return The report's path.
+     * @throws std::exception If a page read fails or the report cannot be written.
+     */
+    std::string runOnce();
+
+    /**
+     * @brief Stops the job; a run in progress finishes first.
+     */
+    void stop();
+
+    /**
+     * @brief The first time after `now` that the clock reads `hourUtc`:00 UTC.
+     */
+    static std::chrono::system_clock::time_point nextRun(std::chrono::system_clock::time_point now, int hourUtc);
+
+private:
+    void run();
+
+    const Reconciler::ScanReader reader;
+    const BalanceReader balances;
+    const std::string directory;
+    const int hourUtc;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+};
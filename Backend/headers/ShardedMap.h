@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+
+/**
+ * @brief Hash map split into kShards cache-line-aligned shards, each with its own lock.
+ *
+ * This is the per-account state behind the feeds, logs and ledgers: accounts are spread over the
+ * shards, so threads working on different accounts rarely share a lock. Integral keys are
+ * sharded by their low bits, so an account always lands in the same shard from run to run.
+ *
+ * There are two ways to use it:
+ * - get() and find() return a reference to the element and release the shard lock. Elements of an
+ *   unordered_map never move, so the reference stays valid; the element does its own locking.
+ *   Maps used this way must never erase.
+ * - shardFor() returns the shard, and the caller locks it and uses its entries directly. Maps used
+ *   only this way may erase.
+ */
+template <typename Key, typename T>
+class ShardedMap {
+public:
+    static constexpr std::size_t kShards = 64;
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, T> entries;
+    };
+
+    /**
+     * @brief The key's element, default-constructed the first time. Write paths only; use find() to read.
+     */
+    T& get(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.entries[key];
+    }
+
+    /**
+     * @brief The key's element, or nullptr if it has none. Never inserts.
+     */
+    T* find(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        return it == shard.entries.end() ? nullptr : &it->second;
+    }
+
+    Shard& shardFor(const Key& key) { return shards[indexOf(key)]; }
+    Shard& shard(std::size_t index) { return shards[index]; }
+
+    typename std::array<Shard, kShards>::iterator begin() { return shards.begin(); }
+    typename std::array<Shard, kShards>::iterator end() { return shards.end(); }
+
+private:
+    static std::size_t indexOf(const Key& key) {
+        if constexpr (std::is_integral<Key>::value) {
+            return static_cast<std::size_t>(static_cast<uint32_t>(key) % kShards);
+        } else {
+            return std::hash<Key>{}(key) % kShards;
+        }
+    }
+
+    std::array<Shard, kShards> shards;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "crow_all.h"
+#include "Transaction.h"
+
+/**
+ * @brief Renders monthly account statements through a precompiled crow::mustache template.
+ *
+ * A statement scans the account's history page by page in transaction ID order, which need not
+ * be date order. The opening balance is the sum of every transaction dated before the month.
+ * Transactions inside the month become statement lines, sorted by date and then ID, each with the
+ * running balance from the opening balance. Sums are kept in integer cents. Amounts are signed,
+ * as they are stored.
+ *
+ * run() spreads a batch of accounts over a fixed set of worker threads. A worker claims a
+ * small block of accounts at a time, renders them one by one into a reused buffer, and hands
+ * each document to the sink before the next. Memory is therefore bounded by the thread count,
+ * one history page and one month of lines per thread, however many accounts are in the batch.
+ */
+class StatementGenerator {
+public:
+    /**
+     * @brief Reads up to `limit` transactions of an account with IDs above `afterTransactionID`, in ID order.
+     */
+    using PageReader = std::function<std::vector<Transaction>(int accountID, int afterTransactionID, std::size_t limit)>;
+
+    /**
+     * @brief Receives each rendered statement. It is called from several workers at once.
+     */
+    using Sink = std::function<void(int accountID, const std::string& document)>;
+
+    struct RunStats {
+        std::size_t statements = 0;   // statements rendered and handed to the sink
+        std::size_t failed = 0;       // accounts whose history could not be read or written
+        std::size_t transactions = 0; // statement lines across all statements
+        std::size_t bytes = 0;        // size of all rendered documents
+        double seconds = 0.0;
+    };
+
+    static constexpr std::size_t kPageSize = 1000;
+
+    /**
+     * @brief Uses the built-in HTML template, laid out for printing to PDF.
+     */
+    StatementGenerator();
+
+    /**
+     * @brief Uses a custom template, e.g. crow::mustache::load("statement.html").
+     *
+     * The template sees accountID, month, openingBalance, closingBalance, totalIn, totalOut,
+     * transactionCount, and a `lines` list whose entries have transactionID, date, type,
+     * amount and balance. Money values are preformatted strings with two decimals.
+     */
+    explicit StatementGenerator(crow::mustache::template_t statementTemplate);
+
+    /**
+     * @brief Checks that a month is given as YYYY-MM.
+     */
+    static bool validMonth(const std::string& month);
+
+    /**
+     * @brief Renders one account's statement for a month and appends it to `out`.
+     * @return The number of statement lines.
+     * @throws std::exception If a page read fails.
+     */
+    std::size_t render(int accountID, const std::string& month, const PageReader& reader, std::string& out);
+
+    /**
+     * @brief Renders the statements of many accounts in parallel.
+     * @param accountIDs The accounts in the batch.
+     * @param month The statement month, YYYY-MM.
+     * @param reader Reads one history page; Transaction::getTransactionsPage in production.
+     * @param sink Receives each document.
+     * @param threads Worker count; 0 uses one per hardware thread.
+     */
+    RunStats run(const std::vector<int>& accountIDs, const std::string& month, const PageReader& reader,
+                 const Sink& sink, std::size_t threads = 0);
+
+    /**
+     * @brief A sink that writes each statement to `<directory>/<accountID>-<month>.html`.
+     */
+    static Sink directorySink(const std::string& directory, const std::string& month);
+
+private:
+    crow::mustache::template_t statementTemplate;
+};
@@ -1,24 +1,43 @@
 #pragma once
 
+#include <cstddef>
+#include <limits>
 #include <string>
 #include <vector>
 
+template <typename T>
+struct JsonFields;
+
 class Transaction {
 public:
-    Transaction(int transactionID, int accountID, const std::string& transactionType, double amount, const std::string& date);
+    Transaction(int transactionID, int accountID, const std::string& transactionType, double amount, const std::string& date, double balanceAfter = std::numeric_limits<double>::quiet_NaN());
 
     int getTransactionID() const;
     int getAccountID() const;
     std::string getTransactionType() const;
     double getAmount() const;
     std::string getDate() const;
+    double getBalanceAfter() const;
+    bool hasBalanceAfter() const;
+    void setBalanceAfter(double newBalanceAfter);
+
+    std::string toJson() const;
+    bool saveToDatabase() const;
+    bool publish() const;
 
     static std::vector<Transaction> getTransactions(int accountID);
+    static std::vector<Transaction> getTransactionsPage(int accountID, int afterTransactionID, std::size_t limit);
+    static std::vector<Transaction> getAllTransactionsPage(int afterTransactionID, std::size_t limit);
+    static int nextTransactionID();
+    static std::string today();
 
 private:
+    friend struct JsonFields<Transaction>;
+
     int transactionID;
     int accountID;
     std::string transactionType;
     double amount;
     std::string date;
+    double balanceAfter; // the account balance once this transaction was committed; NaN for rows stored without one
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "crow_all.h"
+#include "PriorityScheduler.h"
+#include "Transaction.h"
+
+/**
+ * @brief Streams an account's full transaction history as CSV or NDJSON with chunked encoding.
+ *
+ * History is read in pages ordered by transaction ID. Pages are read on the priority scheduler,
+ * never on the connection's thread. While one page is formatted and written, the next is read.
+ * At most two pages are held at any time, so memory stays flat however long the history is.
+ */
+class TransactionExport {
+public:
+    enum class Format { Csv, Ndjson };
+
+    /**
+     * @brief Reads up to `limit` transactions of an account with IDs above `afterTransactionID`, in ID order.
+     */
+    using PageReader = std::function<std::vector<Transaction>(int accountID, int afterTransactionID, std::size_t limit)>;
+
+    static constexpr std::size_t kPageSize = 1000;
+
+    /**
+     * @brief Builds the source for crow::response::stream_events().
+     * @param accountID The account to export.
+     * @param format CSV (with a header row) or one JSON object per line.
+     * @param reader Reads one page; Transaction::getTransactionsPage in production.
+     * @param scheduler The pool the pages are read on.
+     * @param pageSize Transactions per page.
+     */
+    static std::function<bool(std::string&, const crow::stream_waker&)> source(
+        int accountID, Format format, PageReader reader, PriorityScheduler& scheduler, std::size_t pageSize = kPageSize);
+
+    static void appendCsvRow(std::string& out, const Transaction& transaction);
+    static void appendNdjsonRow(std::string& out, const Transaction& transaction);
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ShardedMap.h"
+#include "Transaction.h"
+
+namespace crow {
+    class stream_waker;
+}
+
+/**
+ * @brief In-memory tail of each account's newest transactions, served as server-sent events.
+ *
+ * Every committed transaction gets the next sequence number of its account and is encoded once
+ * as an SSE event (`id: <sequence>`, `event: transaction`, the transaction JSON as data). The
+ * last kTailCapacity events per account stay in memory, so a client resuming with Last-Event-ID
+ * is answered from the tail without touching storage. A cursor that has fallen out of the tail,
+ * or is ahead of it after a restart, gets a `reset` event carrying the current head; the client
+ * then reloads the history once and continues from there.
+ *
+ * Only append() creates an account's tail, so streaming an account that has no transactions yet
+ * does not grow the feed. Its streams wait aside until the first event or the next heartbeat.
+ */
+class TransactionFeed {
+public:
+    static constexpr std::size_t kTailCapacity = 256;
+
+    enum class ReadStatus { Events, Empty, Gap };
+
+    /**
+     * @brief The process-wide feed; the heartbeat thread starts on first use.
+     */
+    static TransactionFeed& instance();
+
+    ~TransactionFeed();
+
+    TransactionFeed(const TransactionFeed&) = delete;
+    TransactionFeed& operator=(const TransactionFeed&) = delete;
+
+    /**
+     * @brief Adds a committed transaction to its account's tail and wakes the account's streams.
+     * @param transaction The transaction.
+     * @return The transaction's sequence number within its account.
+     */
+    uint64_t append(const Transaction& transaction);
+
+    /**
+     * @brief Copies the events after a cursor.
+     * @param accountID The account.
+     * @param cursor The last sequence the client has; advanced past what is copied, or to the head on a gap.
+     * @param out Receives the encoded events.
+     * @param maxBytes Stops after the event that takes out past this size.
+     * @return Gap if the cursor is not in the tail, Empty if nothing is newer.
+     */
+    ReadStatus read(int accountID, uint64_t& cursor, std::string& out, std::size_t maxBytes);
+
+    /**
+     * @brief The newest sequence number of an account, 0 if it has none yet.
+     */
+    uint64_t head(int accountID);
+
+    /**
+     * @brief Calls wake once when the account has events after the cursor, or at the next heartbeat.
+     */
+    void wait(int accountID, uint64_t cursor, std::function<void()> wake);
+
+    /**
+     * @brief Builds the chunk source for crow::response::stream_events() that streams an account's events.
+     * @param accountID The account.
+     * @param cursor The client's Last-Event-ID; events after it are sent first.
+     */
+    std::function<bool(std::string&, const crow::stream_waker&)> eventSource(int accountID, uint64_t cursor);
+
+    /**
+     * @brief Stops the heartbeat thread; call before the server's io_services are destroyed.
+     */
+    void stop();
+
+private:
+    struct Event {
+        uint64_t sequence;
+        std::shared_ptr<const std::string> text;
+    };
+
+    struct Tail {
+        std::mutex mutex;
+        std::deque<Event> events;
+        uint64_t head = 0;
+        std::vector<std::function<void()>> waiters;
+    };
+
+    TransactionFeed();
+
+    void run();
+
+    ShardedMap<int, Tail> tails;
+
+    // streams waiting on accounts that have no tail yet
+    std::mutex idleMutex;
+    std::unordered_map<int, std::vector<std::function<void()>>> idle;
+
+    std::mutex heartbeatMutex;
+    std::condition_variable heartbeatWake;
+    bool stopping = false;
+    std::thread heartbeat;
+};
@@ -5,6 +5,9 @@
 #include <functional>
 #include <firebase/database.h>
 
+template <typename T>
+struct JsonFields;
+
 class User {
 public:
     User() = default;
@@ -20,6 +23,9 @@ public:
     std::string getCardNum() const;
     void setCardNum(const std::string& newCardNum);
 
+    // Serialize the user as a JSON object
+    std::string toJson() const;
+
     // Save user data to the database
     void saveUser();
 
@@ -27,9 +33,11 @@ public:
     bool loadFromDatabase(firebase::database::Database* database);
 
     // Fetch user data asynchronously
-    static void fetchUser(firebase::database::Database* database, int userID, const function<void(User)>& callback);
+    static void fetchUser(firebase::database::Database* database, int userID, const std::function<void(User)>& callback);
 
 private:
+    friend struct JsonFields<User>;
+
     int userID;
     std::string username;
     std::string cardNum;
@@ -333,7 +333,8 @@ namespace crow
         query_string(std::string url)
             : url_(std::move(url))
         {
-            if (url_.empty())
+            // most URLs have no query, and sizing the table for one costs a 2K allocation
+            if (url_.find_first_of("?#") == std::string::npos)
                 return;
 
             key_value_pairs_.resize(MAX_KEY_VALUE_PAIRS_COUNT);
@@ -3350,6 +3351,8 @@ namespace crow
     struct SocketAdaptor
     {
         using context = void;
+        // a plain socket can wait for readability and then read without blocking
+        static constexpr bool wait_for_readable = true;
         SocketAdaptor(boost::asio::io_context& io_context, context*)
             : socket_(io_context)
         {
@@ -3399,6 +3402,8 @@ namespace crow
     {
         using context = boost::asio::ssl::context;
         using ssl_socket_t = boost::asio::ssl::stream<tcp::socket>;
+        // TLS records may already be buffered by the stream, so reads stay asynchronous
+        static constexpr bool wait_for_readable = false;
         SSLAdaptor(boost::asio::io_context& io_context, context* ctx)
             : ssl_socket_(new ssl_socket_t(io_context, *ctx))
         {
@@ -5054,7 +5059,8 @@ namespace crow
 
                 }
 
-                static json::wvalue empty_str;
+                // callers get a mutable reference, so every rendering thread needs its own
+                thread_local json::wvalue empty_str;
                 empty_str = "";
                 return {false, empty_str};
             }
@@ -5236,6 +5242,18 @@ namespace crow
                 return ret;
             }
 
+            // Appends to out, so a caller rendering many documents can reuse one buffer.
+            // Rendering reads the compiled template and writes only to out and to thread-local
+            // state (the stand-in find_context returns for a missing tag), so one template can
+            // be shared by threads as long as each renders its own context.
+            void render(context& ctx, std::string& out)
+            {
+                std::vector<context*> stack;
+                stack.emplace_back(&ctx);
+
+                render_internal(0, fragments_.size()-1, stack, out, 0);
+            }
+
         private:
 
             void parse()
@@ -5652,10 +5670,20 @@ namespace crow
 #pragma once
 
 #include <boost/asio.hpp>
+#include <atomic>
 #include <deque>
 #include <functional>
 #include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
 
 
@@ -5664,11 +5692,83 @@ namespace crow
 {
     namespace detail 
     {
-        // fast timer queue for fixed tick value.
-        class dumb_timer_queue
+        // The reactor Boost.Asio was built with; chosen at build time (see BANKING_IO_URING in CMakeLists.txt).
+        inline const char* network_backend()
+        {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+            return "io_uring";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+            return "epoll";
+#elif defined(BOOST_ASIO_HAS_KQUEUE)
+            return "kqueue";
+#elif defined(BOOST_ASIO_HAS_IOCP)
+            return "iocp";
+#else
+            return "select";
+#endif
+        }
+
+        // Online CPUs ordered node by node from sysfs, so pinning workers in this order
+        // keeps neighbouring workers on one NUMA node. Falls back to 0..n-1.
+        inline std::vector<int> cpus_by_numa_node()
+        {
+            std::vector<int> cpus;
+            for (int node = 0; ; node++)
+            {
+                std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!list)
+                    break;
+                std::string ranges;
+                std::getline(list, ranges);
+                std::stringstream ss(ranges);
+                std::string range;
+                while (std::getline(ss, range, ','))
+                {
+                    auto dash = range.find('-');
+                    int first = std::atoi(range.c_str());
+                    int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                    for (int cpu = first; cpu <= last; cpu++)
+                        cpus.push_back(cpu);
+                }
+            }
+            if (cpus.empty())
+            {
+                unsigned count = std::thread::hardware_concurrency();
+                for (unsigned cpu = 0; cpu < count; cpu++)
+                    cpus.push_back((int)cpu);
+            }
+            return cpus;
+        }
+
+        // Deadlines applied to every connection of a server. A zero duration disables that deadline.
+        struct connection_timeouts
+        {
+            // time a keep-alive connection may sit between requests
+            std::chrono::milliseconds idle{5000};
+            // time allowed to receive one request, from its first byte (or the accept) to the end of the body
+            std::chrono::milliseconds read{5000};
+            // time an asynchronous handler may take before res.end(); the connection is closed when it expires
+            std::chrono::milliseconds handler{0};
+            // resolution of the timer wheel; deadlines fire up to one tick late
+            std::chrono::milliseconds granularity{1000};
+        };
+
+        // Hashed timer wheel, one per io_service thread. add() and cancel() are O(1):
+        // entries live in a slab and are linked into the slot their deadline hashes to,
+        // and process() only visits the slots for the ticks that have passed.
+        class timer_wheel
         {
         public:
-            using key = std::pair<dumb_timer_queue*, int>;
+            // the wheel pointer and the entry's slab index and generation;
+            // a stale key (already fired or cancelled) is ignored by cancel()
+            using key = std::pair<timer_wheel*, uint64_t>;
+
+            explicit timer_wheel(std::chrono::milliseconds granularity = std::chrono::milliseconds(1000))
+                : granularity_(granularity.count() > 0 ? granularity : std::chrono::milliseconds(1)),
+                  slots_(slot_count, npos),
+                  last_tick_(std::chrono::steady_clock::now())
+            {
+            }
 
             void cancel(key& k)
             {
@@ -5677,18 +5777,39 @@ namespace crow
                 if (!self)
                     return;
 
-                unsigned int index = (unsigned int)(k.second - self->step_);
-                if (index < self->dq_.size())
-                    self->dq_[index].second = nullptr;
+                uint32_t index = (uint32_t)k.second;
+                uint32_t generation = (uint32_t)(k.second >> 32);
+                if (index < self->nodes_.size() && self->nodes_[index].generation == generation && self->nodes_[index].linked)
+                {
+                    self->unlink(index);
+                    self->free_node(index);
+                }
             }
 
-            key add(std::function<void()> f)
+            key add(std::function<void()> f, std::chrono::milliseconds timeout)
             {
-                dq_.emplace_back(std::chrono::steady_clock::now(), std::move(f));
-                int ret = step_+dq_.size()-1;
+                // slot current_ + n is processed at last_tick_ + n * granularity, and last_tick_ can be
+                // almost a tick behind now, so count from last_tick_ to never fire early; a partial
+                // millisecond behind is rounded up for the same reason
+                auto behind = std::chrono::ceil<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last_tick_);
+                uint64_t ticks = (behind.count() + timeout.count() + granularity_.count() - 1) / granularity_.count();
+                if (ticks == 0)
+                    ticks = 1;
 
-                CROW_LOG_DEBUG << "timer add inside: " << this << ' ' << ret ;
-                return {this, ret};
+                uint32_t index = alloc_node();
+                node& n = nodes_[index];
+                n.f = std::move(f);
+                n.rounds = (ticks - 1) / slot_count;
+                n.slot = (uint32_t)((current_ + ticks) & (slot_count - 1));
+                link(index);
+
+                CROW_LOG_DEBUG << "timer add inside: " << this << ' ' << index;
+                return {this, ((uint64_t)n.generation << 32) | index};
+            }
+
+            key add(std::function<void()> f)
+            {
+                return add(std::move(f), std::chrono::milliseconds(5000));
             }
 
             void process()
@@ -5697,19 +5818,34 @@ namespace crow
                     return;
 
                 auto now = std::chrono::steady_clock::now();
-                while(!dq_.empty())
+                while (now - last_tick_ >= granularity_)
                 {
-                    auto& x = dq_.front();
-                    if (now - x.first < std::chrono::seconds(tick))
-                        break;
-                    if (x.second)
+                    last_tick_ += granularity_;
+                    current_ = (current_ + 1) & (slot_count - 1);
+
+                    // unlink everything that is due before calling anything, since
+                    // a handler may add or cancel timers in this same slot
+                    for (uint32_t index = slots_[current_]; index != npos; )
+                    {
+                        node& n = nodes_[index];
+                        uint32_t next = n.next;
+                        if (n.rounds > 0)
+                            n.rounds--;
+                        else
+                        {
+                            unlink(index);
+                            expired_.push_back(std::move(n.f));
+                            free_node(index);
+                        }
+                        index = next;
+                    }
+                    for (auto& f : expired_)
                     {
-                        CROW_LOG_DEBUG << "timer call: " << this << ' ' << step_;
+                        CROW_LOG_DEBUG << "timer call: " << this << ' ' << current_;
                         // we know that timer handlers are very simple currenty; call here
-                        x.second();
+                        f();
                     }
-                    dq_.pop_front();
-                    step_++;
+                    expired_.clear();
                 }
             }
 
@@ -5718,18 +5854,317 @@ namespace crow
                 io_service_ = &io_service;
             }
 
-            dumb_timer_queue() noexcept
+            std::chrono::milliseconds granularity() const
             {
+                return granularity_;
+            }
+
+            size_t size() const
+            {
+                return nodes_.size() - free_count_;
             }
 
         private:
+            static constexpr uint32_t slot_count = 512;
+            static constexpr uint32_t npos = 0xffffffff;
+
+            struct node
+            {
+                std::function<void()> f;
+                uint64_t rounds{};
+                uint32_t slot{};
+                uint32_t prev{npos};
+                uint32_t next{npos};
+                uint32_t generation{};
+                bool linked{};
+            };
+
+            uint32_t alloc_node()
+            {
+                if (free_head_ != npos)
+                {
+                    uint32_t index = free_head_;
+                    free_head_ = nodes_[index].next;
+                    free_count_--;
+                    return index;
+                }
+                nodes_.emplace_back();
+                return (uint32_t)(nodes_.size() - 1);
+            }
+
+            void free_node(uint32_t index)
+            {
+                node& n = nodes_[index];
+                n.f = nullptr;
+                n.generation++;
+                n.next = free_head_;
+                free_head_ = index;
+                free_count_++;
+            }
+
+            void link(uint32_t index)
+            {
+                node& n = nodes_[index];
+                n.prev = npos;
+                n.next = slots_[n.slot];
+                if (n.next != npos)
+                    nodes_[n.next].prev = index;
+                slots_[n.slot] = index;
+                n.linked = true;
+            }
 
-            int tick{5};
+            void unlink(uint32_t index)
+            {
+                node& n = nodes_[index];
+                if (n.prev != npos)
+                    nodes_[n.prev].next = n.next;
+                else
+                    slots_[n.slot] = n.next;
+                if (n.next != npos)
+                    nodes_[n.next].prev = n.prev;
+                n.linked = false;
+            }
+
+            std::chrono::milliseconds granularity_;
             boost::asio::io_service* io_service_{};
-            std::deque<std::pair<decltype(std::chrono::steady_clock::now()), std::function<void()>>> dq_;
-            int step_{};
+            std::vector<node> nodes_;
+            std::vector<uint32_t> slots_;
+            std::vector<std::function<void()>> expired_;
+            uint32_t free_head_{npos};
+            size_t free_count_{};
+            uint32_t current_{};
+            std::chrono::steady_clock::time_point last_tick_;
+        };
+
+        // Counters for the read path; shared by all threads.
+        struct read_buffer_stats
+        {
+            std::atomic<size_t> buffers_in_use{0};
+            std::atomic<size_t> bytes_in_use{0};
+            std::atomic<size_t> bytes_pooled{0};
+            std::atomic<size_t> reads{0};
+            std::atomic<size_t> requests{0};
+        };
+
+        inline read_buffer_stats& get_read_buffer_stats()
+        {
+            static read_buffer_stats stats;
+            return stats;
+        }
+
+        // Per-thread free lists of read buffers in three size classes
+        // (4K, 16K, 64K). Connections borrow a buffer only while bytes are
+        // being copied out of the socket, so idle connections hold none.
+        class read_buffer_pool
+        {
+        public:
+            static constexpr unsigned size_classes = 3;
+            static constexpr size_t max_free_per_class = 64;
+
+            static size_t class_size(unsigned size_class)
+            {
+                return size_t(4096) << (2 * size_class);
+            }
+
+            static unsigned class_for(size_t bytes)
+            {
+                unsigned size_class = 0;
+                while (size_class + 1 < size_classes && class_size(size_class) < bytes)
+                    size_class++;
+                return size_class;
+            }
+
+            static char* acquire(unsigned size_class)
+            {
+                auto& free_list = instance().free_[size_class];
+                auto& stats = get_read_buffer_stats();
+                stats.buffers_in_use++;
+                stats.bytes_in_use += class_size(size_class);
+                if (free_list.empty())
+                    return new char[class_size(size_class)];
+                char* buffer = free_list.back();
+                free_list.pop_back();
+                stats.bytes_pooled -= class_size(size_class);
+                return buffer;
+            }
+
+            static void release(char* buffer, unsigned size_class)
+            {
+                auto& free_list = instance().free_[size_class];
+                auto& stats = get_read_buffer_stats();
+                stats.buffers_in_use--;
+                stats.bytes_in_use -= class_size(size_class);
+                if (free_list.size() >= max_free_per_class)
+                {
+                    delete[] buffer;
+                    return;
+                }
+                free_list.push_back(buffer);
+                stats.bytes_pooled += class_size(size_class);
+            }
+
+        private:
+            ~read_buffer_pool()
+            {
+                for(auto& free_list : free_)
+                    for(auto buffer : free_list)
+                        delete[] buffer;
+            }
+
+            static read_buffer_pool& instance()
+            {
+                static thread_local read_buffer_pool pool;
+                return pool;
+            }
+
+            std::vector<char*> free_[size_classes];
+        };
+
+        // A buffer borrowed from read_buffer_pool; returned on release() or destruction.
+        class pooled_buffer
+        {
+        public:
+            pooled_buffer() = default;
+
+            explicit pooled_buffer(unsigned size_class)
+                : data_(read_buffer_pool::acquire(size_class)), size_class_(size_class)
+            {
+            }
+
+            pooled_buffer(pooled_buffer&& other) noexcept
+                : data_(other.data_), size_class_(other.size_class_)
+            {
+                other.data_ = nullptr;
+            }
+
+            pooled_buffer& operator = (pooled_buffer&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    release();
+                    data_ = other.data_;
+                    size_class_ = other.size_class_;
+                    other.data_ = nullptr;
+                }
+                return *this;
+            }
+
+            ~pooled_buffer()
+            {
+                release();
+            }
+
+            void release()
+            {
+                if (data_)
+                {
+                    read_buffer_pool::release(data_, size_class_);
+                    data_ = nullptr;
+                }
+            }
+
+            char* data() const
+            {
+                return data_;
+            }
+
+            size_t size() const
+            {
+                return data_ ? read_buffer_pool::class_size(size_class_) : 0;
+            }
+
+        private:
+            char* data_{};
+            unsigned size_class_{};
+        };
+
+        // Counters for request arenas; shared by all threads.
+        struct request_arena_stats
+        {
+            std::atomic<size_t> requests{0};
+            std::atomic<size_t> heap_blocks{0}; // blocks an arena needed beyond its pooled one
         };
+
+        inline request_arena_stats& get_request_arena_stats()
+        {
+            static request_arena_stats stats;
+            return stats;
+        }
     }
+
+    // Monotonic memory for the temporaries of one request: its routing parameters, parsed body
+    // and response body. The connection starts the arena with a pooled 16K block when it hands
+    // the request to its handler and resets it once the response has been written, so a request
+    // whose temporaries fit in the block never calls malloc, and idle connections hold no block.
+    // Deallocation does nothing; everything goes at once in reset(). A handler may use the arena
+    // on whichever thread runs it, but not after it has ended the response.
+    class request_arena : public std::pmr::memory_resource
+    {
+    public:
+        request_arena() = default;
+        request_arena(const request_arena&) = delete;
+        request_arena& operator = (const request_arena&) = delete;
+
+        void start()
+        {
+            reset();
+            block_ = detail::pooled_buffer(1);
+            monotonic_.emplace(block_.data(), block_.size(), &heap_);
+            detail::get_request_arena_stats().requests++;
+        }
+
+        void reset()
+        {
+            monotonic_.reset();
+            block_.release();
+        }
+
+        // A string that lives in the arena. It is never destroyed; reset() frees it with the rest.
+        std::pmr::string& make_string()
+        {
+            return *new (allocate(sizeof(std::pmr::string), alignof(std::pmr::string))) std::pmr::string(this);
+        }
+
+    private:
+        // Where blocks come from once the pooled one is full; counted, since they mean malloc calls
+        class counting_heap : public std::pmr::memory_resource
+        {
+            void* do_allocate(size_t bytes, size_t alignment) override
+            {
+                detail::get_request_arena_stats().heap_blocks++;
+                return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override
+            {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+            {
+                return this == &other;
+            }
+        };
+
+        // only called between start() and reset(), while a request holds the arena
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            return monotonic_->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void*, size_t, size_t) override
+        {
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        detail::pooled_buffer block_;
+        counting_heap heap_;
+        std::optional<std::pmr::monotonic_buffer_resource> monotonic_;
+    };
 }
 
 
@@ -6357,10 +6792,18 @@ namespace crow
 
     struct routing_params
     {
-        std::vector<int64_t> int_params;
-        std::vector<uint64_t> uint_params;
-        std::vector<double> double_params;
-        std::vector<std::string> string_params;
+        std::pmr::vector<int64_t> int_params;
+        std::pmr::vector<uint64_t> uint_params;
+        std::pmr::vector<double> double_params;
+        std::pmr::vector<std::pmr::string> string_params;
+
+        routing_params() = default;
+
+        // allocates the parameters from `resource', such as the request's arena
+        explicit routing_params(std::pmr::memory_resource* resource)
+            : int_params(resource), uint_params(resource), double_params(resource), string_params(resource)
+        {
+        }
 
         void debug_print() const
         {
@@ -6405,7 +6848,7 @@ namespace crow
     template<>
     inline std::string routing_params::get<std::string>(unsigned index) const
     {
-        return string_params[index];
+        return std::string(string_params[index]);
     }
 }
 
@@ -6461,9 +6904,11 @@ namespace crow
         query_string url_params;
         ci_map headers;
         std::string body;
+        std::string remote_ip_address;
 
         void* middleware_context{};
         boost::asio::io_service* io_service{};
+        request_arena* arena{}; // set while a connection is handling the request
 
         request()
             : method(HTTPMethod::Get)
@@ -6530,13 +6975,18 @@ namespace crow
             virtual void send_binary(const std::string& msg) = 0;
             virtual void send_text(const std::string& msg) = 0;
             virtual void close(const std::string& msg = "quit") = 0;
+            // the io_service the connection runs on; only touch the connection from its thread
+            virtual boost::asio::io_service& get_io_service() = 0;
+            // bytes handed to send_*() that have not been written to the socket yet;
+            // call on the connection's thread
+            virtual std::size_t send_queue_bytes() const = 0;
             virtual ~connection(){}
 
             void userdata(void* u) { userdata_ = u; }
             void* userdata() { return userdata_; }
 
         private:
-            void* userdata_;
+            void* userdata_{};
 		};
 
 		template <typename Adaptor>
@@ -6622,6 +7072,21 @@ namespace crow
                     });
                 }
 
+                boost::asio::io_service& get_io_service() override
+                {
+                    return adaptor_.get_io_service();
+                }
+
+                std::size_t send_queue_bytes() const override
+                {
+                    std::size_t total = 0;
+                    for(auto& s:sending_buffers_)
+                        total += s.size();
+                    for(auto& s:write_buffers_)
+                        total += s.size();
+                    return total;
+                }
+
                 void close(const std::string& msg) override
                 {
                     dispatch([this, msg]{
@@ -6838,24 +7303,28 @@ namespace crow
                             break;
                         case WebSocketReadState::Payload:
                             {
+                                // the buffer is only borrowed for the payload; between frames the
+                                // connection waits on the 2-byte mini header and holds nothing
+                                buffer_ = detail::pooled_buffer(detail::read_buffer_pool::class_for(remaining_length_));
                                 size_t to_read = buffer_.size();
                                 if (remaining_length_ < to_read)
                                     to_read = remaining_length_;
-                                adaptor_.socket().async_read_some( boost::asio::buffer(buffer_, to_read), 
+                                adaptor_.socket().async_read_some( boost::asio::buffer(buffer_.data(), to_read), 
                                     [this](const boost::system::error_code& ec, std::size_t bytes_transferred)
                                     {
                                         is_reading = false;
 
                                         if (!ec)
                                         {
-                                            fragment_.insert(fragment_.end(), buffer_.begin(), buffer_.begin() + bytes_transferred);
+                                            fragment_.insert(fragment_.end(), buffer_.data(), buffer_.data() + bytes_transferred);
+                                            buffer_.release();
                                             remaining_length_ -= bytes_transferred;
                                             if (remaining_length_ == 0)
                                             {
                                                 handle_fragment();
                                                 state_ = WebSocketReadState::MiniHeader;
-                                                do_read();
                                             }
+                                            do_read();
                                         }
                                         else
                                         {
@@ -7004,7 +7473,7 @@ namespace crow
                 std::vector<std::string> sending_buffers_;
                 std::vector<std::string> write_buffers_;
 
-                boost::array<char, 4096> buffer_;
+                detail::pooled_buffer buffer_;
                 bool is_binary_;
                 std::string message_;
                 std::string fragment_;
@@ -7115,7 +7584,7 @@ namespace crow
             HTTPParser* self = static_cast<HTTPParser*>(self_);
 
             // url params
-            self->url = self->raw_url.substr(0, self->raw_url.find("?"));
+            self->url.assign(self->raw_url, 0, self->raw_url.find("?"));
             self->url_params = query_string(self->raw_url);
 
             self->process_message();
@@ -7141,8 +7610,25 @@ namespace crow
                 on_message_complete,
             };
 
-            int nparsed = http_parser_execute(this, &settings_, buffer, length);
-            return nparsed == length;
+            consumed = http_parser_execute(this, &settings_, buffer, length);
+            return consumed == length || is_paused();
+        }
+
+        // set by the handler from handle() to stop right after the current message;
+        // feed() then reports the bytes it consumed and the rest is fed after resume()
+        void pause()
+        {
+            http_parser_pause(this, 1);
+        }
+
+        void resume()
+        {
+            http_parser_pause(this, 0);
+        }
+
+        bool is_paused() const
+        {
+            return CROW_HTTP_PARSER_ERRNO(this) == HPE_PAUSED;
         }
 
         bool done()
@@ -7177,6 +7663,18 @@ namespace crow
             return request{(HTTPMethod)method, std::move(raw_url), std::move(url), std::move(url_params), std::move(headers), std::move(body)};
         }
 
+        // keep-alive fast path: swaps the message into req, so the parser gets the
+        // previous request's strings back and reuses their capacity
+        void to_request(request& req)
+        {
+            req.method = (HTTPMethod)method;
+            req.raw_url.swap(raw_url);
+            req.url.swap(url);
+            req.url_params = std::move(url_params);
+            req.headers.swap(headers);
+            req.body.swap(body);
+        }
+
 		bool is_upgrade() const
 		{
 			return upgrade;
@@ -7197,6 +7695,8 @@ namespace crow
         query_string url_params;
         std::string body;
 
+        int consumed = 0;
+
         Handler* handler_;
     };
 }
@@ -7206,6 +7706,10 @@ namespace crow
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <boost/algorithm/string.hpp>
 
 
 
@@ -7218,6 +7722,77 @@ namespace crow
 {
     template <typename Adaptor, typename Handler, typename ... Middlewares>
     class Connection;
+    // Header lines encoded once, e.g. a CORS or Content-Type block shared by many routes.
+    // Responses keep only a pointer, so a block must outlive them; make it static.
+    class header_block
+    {
+    public:
+        header_block(std::initializer_list<std::pair<std::string, std::string>> headers)
+        {
+            for(auto& kv : headers)
+            {
+                encoded_ += kv.first;
+                encoded_ += ": ";
+                encoded_ += kv.second;
+                encoded_ += "\r\n";
+                names_.push_back(boost::algorithm::to_lower_copy(kv.first));
+            }
+        }
+
+        const std::string& encoded() const
+        {
+            return encoded_;
+        }
+
+        // name must be lower case
+        bool contains(const std::string& name) const
+        {
+            return std::find(names_.begin(), names_.end(), name) != names_.end();
+        }
+
+    private:
+        std::string encoded_;
+        std::vector<std::string> names_;
+    };
+
+    namespace detail
+    {
+        // shared by a streaming connection and the wakers it hands out; the connection
+        // clears it when it goes away, so a late wake-up does nothing
+        struct stream_wakeup
+        {
+            std::mutex mutex;
+            boost::asio::io_service* io{};
+            std::function<void()> resume; // only used on io's thread
+        };
+    }
+
+    // Wakes a stream that is waiting for data (see response::stream_events); may be
+    // called from any thread and outlive the connection.
+    class stream_waker
+    {
+    public:
+        stream_waker() = default;
+        explicit stream_waker(std::weak_ptr<detail::stream_wakeup> wakeup) : wakeup_(std::move(wakeup)) {}
+
+        void operator()() const
+        {
+            auto wakeup = wakeup_.lock();
+            if (!wakeup)
+                return;
+            std::lock_guard<std::mutex> lock(wakeup->mutex);
+            if (!wakeup->io)
+                return;
+            wakeup->io->post([wakeup]{
+                if (wakeup->resume)
+                    wakeup->resume();
+            });
+        }
+
+    private:
+        std::weak_ptr<detail::stream_wakeup> wakeup_;
+    };
+
     struct response
     {
         template <typename Adaptor, typename Handler, typename ... Middlewares>
@@ -7245,6 +7820,23 @@ namespace crow
             return crow::get_header_value(headers, key);
         }
 
+        // Sends the block's lines as they are, without re-serialising them.
+        void add_header_block(const header_block& block)
+        {
+            header_blocks_.push_back(&block);
+        }
+
+        // name must be lower case; checks both headers and header blocks
+        bool has_header(const std::string& name) const
+        {
+            if (headers.count(name))
+                return true;
+            for(auto block : header_blocks_)
+                if (block->contains(name))
+                    return true;
+            return false;
+        }
+
 
         response() {}
         explicit response(int code) : code(code) {}
@@ -7273,10 +7865,16 @@ namespace crow
         response& operator = (response&& r) noexcept
         {
             body = std::move(r.body);
+            body_view_ = r.body_view_;
+            r.body_view_ = {};
             json_value = std::move(r.json_value);
             code = r.code;
             headers = std::move(r.headers);
+            header_blocks_.swap(r.header_blocks_);
+            r.header_blocks_.clear();
             completed_ = r.completed_;
+            chunk_source_ = std::move(r.chunk_source_);
+            event_source_ = std::move(r.event_source_);
             return *this;
         }
 
@@ -7288,10 +7886,22 @@ namespace crow
         void clear()
         {
             body.clear();
+            body_view_ = {};
             json_value.clear();
             code = 200;
             headers.clear();
+            header_blocks_.clear();
             completed_ = false;
+            chunk_source_ = nullptr;
+            event_source_ = nullptr;
+        }
+
+        // Sends `text' as the body instead of `body', without copying it. The text must stay
+        // valid until the response has been written, as a string made by the request's arena does.
+        void set_body_view(std::string_view text)
+        {
+            body.clear();
+            body_view_ = text;
         }
 
         void redirect(const std::string& location)
@@ -7329,10 +7939,36 @@ namespace crow
             return is_alive_helper_ && is_alive_helper_();
         }
 
-        private:
-            bool completed_{};
-            std::function<void()> complete_request_handler_;
-            std::function<bool()> is_alive_helper_;
+        // Send the body with chunked transfer encoding instead of from `body'.
+        // `source' appends the next chunk to its argument and returns false
+        // after the last one; it is called on the connection's thread.
+        void stream(std::function<bool(std::string&)> source)
+        {
+            chunk_source_ = std::move(source);
+        }
+
+        // Like stream(), for sources that wait for data, such as server-sent events. The
+        // source may return true with an empty chunk when it has nothing to send yet; the
+        // connection then writes nothing until the waker is called and asks it again.
+        // Needs HTTP/1.1; a 1.0 client gets 505.
+        void stream_events(std::function<bool(std::string&, const stream_waker&)> source)
+        {
+            event_source_ = std::move(source);
+        }
+
+        bool is_streaming() const
+        {
+            return chunk_source_ || event_source_;
+        }
+
+        private:
+            bool completed_{};
+            std::string_view body_view_;
+            std::vector<const header_block*> header_blocks_;
+            std::function<bool(std::string&)> chunk_source_;
+            std::function<bool(std::string&, const stream_waker&)> event_source_;
+            std::function<void()> complete_request_handler_;
+            std::function<bool()> is_alive_helper_;
 
             //In case of a JSON object, set the Content-Type header
             void json_mode()
@@ -8117,134 +8753,67 @@ public:
             if (!head()->IsSimpleNode())
                 throw std::runtime_error("Internal error: Trie header should be simple!");
             optimize();
+            compile();
         }
 
-        std::pair<unsigned, routing_params> find(const std::string& req_url, const Node* node = nullptr, unsigned pos = 0, routing_params* params = nullptr) const
+        // Returns the index of the best matching rule (0 if none) and fills
+        // `params'. Only the flattened table built by validate() is searched;
+        // candidate parameters are kept as offsets into `req_url' and turned
+        // into values once, for the winning rule. `params' keeps its capacity
+        // between calls, so a reused object makes lookups allocation free.
+        unsigned find(const std::string& req_url, routing_params& params) const
         {
-            routing_params empty;
-            if (params == nullptr)
-                params = &empty;
+            params.int_params.clear();
+            params.uint_params.clear();
+            params.double_params.clear();
 
             unsigned found{};
-            routing_params match_params;
-
-            if (node == nullptr)
-                node = head();
-            if (pos == req_url.size())
-                return {node->rule_index, *params};
-
-            auto update_found = [&found, &match_params](std::pair<unsigned, routing_params>& ret)
-            {
-                if (ret.first && (!found || found > ret.first))
-                {
-                    found = ret.first;
-                    match_params = std::move(ret.second);
-                }
-            };
-
-            if (node->param_childrens[(int)ParamType::INT])
-            {
-                char c = req_url[pos];
-                if ((c >= '0' && c <= '9') || c == '+' || c == '-')
-                {
-                    char* eptr;
-                    errno = 0;
-                    long long int value = strtoll(req_url.data()+pos, &eptr, 10);
-                    if (errno != ERANGE && eptr != req_url.data()+pos)
-                    {
-                        params->int_params.push_back(value);
-                        auto ret = find(req_url, &nodes_[node->param_childrens[(int)ParamType::INT]], eptr - req_url.data(), params);
-                        update_found(ret);
-                        params->int_params.pop_back();
-                    }
-                }
-            }
-
-            if (node->param_childrens[(int)ParamType::UINT])
-            {
-                char c = req_url[pos];
-                if ((c >= '0' && c <= '9') || c == '+')
-                {
-                    char* eptr;
-                    errno = 0;
-                    unsigned long long int value = strtoull(req_url.data()+pos, &eptr, 10);
-                    if (errno != ERANGE && eptr != req_url.data()+pos)
-                    {
-                        params->uint_params.push_back(value);
-                        auto ret = find(req_url, &nodes_[node->param_childrens[(int)ParamType::UINT]], eptr - req_url.data(), params);
-                        update_found(ret);
-                        params->uint_params.pop_back();
-                    }
-                }
-            }
+            unsigned best_count{};
+            ParamSpan current[MAX_PARAMS];
+            ParamSpan best[MAX_PARAMS];
+            if (!flat_nodes_.empty())
+                match(req_url, 0, 0, current, 0, found, best, best_count);
 
-            if (node->param_childrens[(int)ParamType::DOUBLE])
+            size_t string_count = 0;
+            for(unsigned i = 0; i < best_count; i ++)
             {
-                char c = req_url[pos];
-                if ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.')
+                const ParamSpan& p = best[i];
+                switch(p.type)
                 {
-                    char* eptr;
-                    errno = 0;
-                    double value = strtod(req_url.data()+pos, &eptr);
-                    if (errno != ERANGE && eptr != req_url.data()+pos)
-                    {
-                        params->double_params.push_back(value);
-                        auto ret = find(req_url, &nodes_[node->param_childrens[(int)ParamType::DOUBLE]], eptr - req_url.data(), params);
-                        update_found(ret);
-                        params->double_params.pop_back();
-                    }
-                }
-            }
-
-            if (node->param_childrens[(int)ParamType::STRING])
-            {
-                size_t epos = pos;
-                for(; epos < req_url.size(); epos ++)
-                {
-                    if (req_url[epos] == '/')
+                    case ParamType::INT:
+                        params.int_params.push_back(p.int_value);
+                        break;
+                    case ParamType::UINT:
+                        params.uint_params.push_back(p.uint_value);
+                        break;
+                    case ParamType::DOUBLE:
+                        params.double_params.push_back(p.double_value);
+                        break;
+                    default:
+                        if (string_count < params.string_params.size())
+                            params.string_params[string_count].assign(req_url, p.begin, p.end - p.begin);
+                        else
+                            params.string_params.emplace_back(req_url, p.begin, p.end - p.begin);
+                        string_count ++;
                         break;
-                }
-
-                if (epos != pos)
-                {
-                    params->string_params.push_back(req_url.substr(pos, epos-pos));
-                    auto ret = find(req_url, &nodes_[node->param_childrens[(int)ParamType::STRING]], epos, params);
-                    update_found(ret);
-                    params->string_params.pop_back();
-                }
-            }
-
-            if (node->param_childrens[(int)ParamType::PATH])
-            {
-                size_t epos = req_url.size();
-
-                if (epos != pos)
-                {
-                    params->string_params.push_back(req_url.substr(pos, epos-pos));
-                    auto ret = find(req_url, &nodes_[node->param_childrens[(int)ParamType::PATH]], epos, params);
-                    update_found(ret);
-                    params->string_params.pop_back();
-                }
-            }
-
-            for(auto& kv : node->children)
-            {
-                const std::string& fragment = kv.first;
-                const Node* child = &nodes_[kv.second];
-
-                if (req_url.compare(pos, fragment.size(), fragment) == 0)
-                {
-                    auto ret = find(req_url, child, pos + fragment.size(), params);
-                    update_found(ret);
                 }
             }
+            params.string_params.resize(string_count);
+            return found;
+        }
 
-            return {found, match_params};
+        std::pair<unsigned, routing_params> find(const std::string& req_url) const
+        {
+            routing_params params;
+            unsigned found = find(req_url, params);
+            return {found, std::move(params)};
         }
 
         void add(const std::string& url, unsigned rule_index)
         {
             unsigned idx{0};
+            unsigned param_count{0};
+            flat_nodes_.clear();
 
             for(unsigned i = 0; i < url.size(); i ++)
             {
@@ -8277,6 +8846,8 @@ public:
                             }
                             idx = nodes_[idx].param_childrens[(int)x.type];
                             i += x.name.size();
+                            if (++param_count > MAX_PARAMS)
+                                throw std::runtime_error("too many parameters in " + url);
                             break;
                         }
                     }
@@ -8298,6 +8869,167 @@ public:
                 throw std::runtime_error("handler already exists for " + url);
             nodes_[idx].rule_index = rule_index;
         }
+    private:
+        static const unsigned MAX_PARAMS = 16;
+
+        // A child edge of a flattened node; its key lives in key_pool_.
+        struct FlatEdge
+        {
+            uint32_t key_offset;
+            uint32_t key_length;
+            unsigned child;
+        };
+
+        // Same layout as Node, with children stored as a sorted edge range.
+        struct FlatNode
+        {
+            unsigned rule_index{};
+            std::array<unsigned, (int)ParamType::MAX> param_childrens{};
+            uint32_t edge_begin{};
+            uint32_t edge_end{};
+        };
+
+        // A parameter matched on the current path, as a range of the url.
+        struct ParamSpan
+        {
+            ParamType type;
+            uint32_t begin;
+            uint32_t end;
+            union
+            {
+                int64_t int_value;
+                uint64_t uint_value;
+                double double_value;
+            };
+        };
+
+        // Copies the (optimized) node graph into contiguous arrays. Node indices
+        // are kept, and every node's edges are sorted by key so a lookup can
+        // jump straight to the edges starting with the next url character.
+        void compile()
+        {
+            flat_nodes_.assign(nodes_.size(), FlatNode{});
+            flat_edges_.clear();
+            key_pool_.clear();
+
+            std::vector<std::pair<std::string, unsigned>> sorted;
+            for(size_t i = 0; i < nodes_.size(); i ++)
+            {
+                const Node& node = nodes_[i];
+                FlatNode& flat = flat_nodes_[i];
+                flat.rule_index = node.rule_index;
+                flat.param_childrens = node.param_childrens;
+
+                sorted.assign(node.children.begin(), node.children.end());
+                std::sort(sorted.begin(), sorted.end());
+
+                flat.edge_begin = flat_edges_.size();
+                for(auto& kv : sorted)
+                {
+                    flat_edges_.push_back(FlatEdge{(uint32_t)key_pool_.size(), (uint32_t)kv.first.size(), kv.second});
+                    key_pool_ += kv.first;
+                }
+                flat.edge_end = flat_edges_.size();
+            }
+        }
+
+        // Depth-first search over the flattened table. Like the node walk it
+        // replaces, every branch is tried and the lowest rule index wins, so
+        // routes keep the priority of their registration order.
+        void match(const std::string& url, unsigned node_index, size_t pos, ParamSpan* current, unsigned depth, unsigned& found, ParamSpan* best, unsigned& best_count) const
+        {
+            const FlatNode& node = flat_nodes_[node_index];
+            if (pos == url.size())
+            {
+                if (node.rule_index && (!found || found > node.rule_index))
+                {
+                    found = node.rule_index;
+                    std::copy(current, current + depth, best);
+                    best_count = depth;
+                }
+                return;
+            }
+
+            auto descend = [&](ParamType type, size_t epos, unsigned child)
+            {
+                if (depth >= MAX_PARAMS)
+                    return;
+                current[depth].type = type;
+                current[depth].begin = pos;
+                current[depth].end = epos;
+                match(url, child, epos, current, depth + 1, found, best, best_count);
+            };
+
+            char c = url[pos];
+            const bool can_capture = depth < MAX_PARAMS;
+            if (can_capture && node.param_childrens[(int)ParamType::INT] && ((c >= '0' && c <= '9') || c == '+' || c == '-'))
+            {
+                char* eptr;
+                errno = 0;
+                long long int value = strtoll(url.data()+pos, &eptr, 10);
+                if (errno != ERANGE && eptr != url.data()+pos)
+                {
+                    current[depth].int_value = value;
+                    descend(ParamType::INT, eptr - url.data(), node.param_childrens[(int)ParamType::INT]);
+                }
+            }
+
+            if (can_capture && node.param_childrens[(int)ParamType::UINT] && ((c >= '0' && c <= '9') || c == '+'))
+            {
+                char* eptr;
+                errno = 0;
+                unsigned long long int value = strtoull(url.data()+pos, &eptr, 10);
+                if (errno != ERANGE && eptr != url.data()+pos)
+                {
+                    current[depth].uint_value = value;
+                    descend(ParamType::UINT, eptr - url.data(), node.param_childrens[(int)ParamType::UINT]);
+                }
+            }
+
+            if (can_capture && node.param_childrens[(int)ParamType::DOUBLE] && ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.'))
+            {
+                char* eptr;
+                errno = 0;
+                double value = strtod(url.data()+pos, &eptr);
+                if (errno != ERANGE && eptr != url.data()+pos)
+                {
+                    current[depth].double_value = value;
+                    descend(ParamType::DOUBLE, eptr - url.data(), node.param_childrens[(int)ParamType::DOUBLE]);
+                }
+            }
+
+            if (node.param_childrens[(int)ParamType::STRING])
+            {
+                size_t epos = url.find('/', pos);
+                if (epos == std::string::npos)
+                    epos = url.size();
+                if (epos != pos)
+                    descend(ParamType::STRING, epos, node.param_childrens[(int)ParamType::STRING]);
+            }
+
+            if (node.param_childrens[(int)ParamType::PATH])
+            {
+                descend(ParamType::PATH, url.size(), node.param_childrens[(int)ParamType::PATH]);
+            }
+
+            // Sibling keys grow from distinct single characters, so none is a prefix of
+            // another and at most one edge matches: the last key not greater than the rest
+            // of the url. std::string compares bytes as unsigned char, like the sort.
+            auto first = flat_edges_.begin() + node.edge_begin;
+            auto last = flat_edges_.begin() + node.edge_end;
+            const std::string_view rest(url.data() + pos, url.size() - pos);
+            auto edge = std::upper_bound(first, last, rest, [this](std::string_view text, const FlatEdge& e)
+            {
+                return text.compare(0, std::string_view::npos, key_pool_.data() + e.key_offset, e.key_length) < 0;
+            });
+            if (edge != first)
+            {
+                --edge;
+                if (rest.compare(0, edge->key_length, key_pool_.data() + edge->key_offset, edge->key_length) == 0)
+                    match(url, edge->child, pos + edge->key_length, current, depth, found, best, best_count);
+            }
+        }
+
     private:
         void debug_node_print(Node* n, int level)
         {
@@ -8362,6 +9094,9 @@ public:
         }
 
         std::vector<Node> nodes_;
+        std::vector<FlatNode> flat_nodes_;
+        std::vector<FlatEdge> flat_edges_;
+        std::string key_pool_;
     };
 
     class Router
@@ -8424,8 +9159,7 @@ public:
 		template <typename Adaptor> 
 		void handle_upgrade(const request& req, response& res, Adaptor&& adaptor)
 		{
-            auto found = trie_.find(req.url);
-            unsigned rule_index = found.first;
+            unsigned rule_index = trie_.find(req.url, thread_params());
             if (!rule_index)
             {
                 CROW_LOG_DEBUG << "Cannot match rules " << req.url;
@@ -8488,9 +9222,10 @@ public:
 
         void handle(const request& req, response& res)
         {
-            auto found = trie_.find(req.url);
-
-            unsigned rule_index = found.first;
+            // a connection's request keeps its parameters in the request arena
+            routing_params arena_params(req.arena ? static_cast<std::pmr::memory_resource*>(req.arena) : std::pmr::get_default_resource());
+            routing_params& params = req.arena ? arena_params : thread_params();
+            unsigned rule_index = trie_.find(req.url, params);
 
             if (!rule_index)
             {
@@ -8534,7 +9269,7 @@ public:
             // any uncaught exceptions become 500s
             try
             {
-                rules_[rule_index]->handle(req, res, found.second);
+                rules_[rule_index]->handle(req, res, params);
             }
             catch(std::exception& e)
             {
@@ -8558,6 +9293,14 @@ public:
         }
 
     private:
+        // Requests without an arena, such as ones built by tests, share one object
+        // per thread; handlers read their parameters synchronously.
+        static routing_params& thread_params()
+        {
+            static thread_local routing_params params;
+            return params;
+        }
+
         std::vector<std::unique_ptr<BaseRule>> rules_;
         Trie trie_;
     };
@@ -8815,6 +9558,75 @@ namespace crow
         }
     }
 
+    namespace detail
+    {
+        // Server and Date lines of one worker thread, kept encoded. The Date line is
+        // rewritten in place at most once a second; it always has the same length, so
+        // writes still in flight keep pointing at valid bytes.
+        class cached_header_lines
+        {
+        public:
+            explicit cached_header_lines(const std::string& server_name)
+                : server_("Server: " + server_name + "\r\n")
+            {
+                update_date();
+            }
+
+            const std::string& server() const
+            {
+                return server_;
+            }
+
+            const std::string& date()
+            {
+                auto now = std::chrono::steady_clock::now();
+                if (now - last_update_ >= std::chrono::seconds(1))
+                    update_date();
+                return date_;
+            }
+
+        private:
+            void update_date()
+            {
+                last_update_ = std::chrono::steady_clock::now();
+                auto last_time_t = time(0);
+                tm my_tm;
+
+#ifdef _MSC_VER
+                gmtime_s(&my_tm, &last_time_t);
+#else
+                gmtime_r(&last_time_t, &my_tm);
+#endif
+                char line[64];
+                size_t size = strftime(line, sizeof(line), "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &my_tm);
+                if (size == date_.size())
+                    std::copy(line, line + size, &date_[0]);
+                else
+                    date_.assign(line, size);
+            }
+
+            std::string server_;
+            std::string date_;
+            std::chrono::steady_clock::time_point last_update_;
+        };
+
+        // Bytes sent in response heads and bodies, and bytes the connection had to copy
+        // or format itself to build them; shared by all threads.
+        struct response_write_stats
+        {
+            std::atomic<size_t> responses{0};
+            std::atomic<size_t> head_bytes{0};
+            std::atomic<size_t> body_bytes{0};
+            std::atomic<size_t> bytes_copied{0};
+        };
+
+        inline response_write_stats& get_response_write_stats()
+        {
+            static response_write_stats stats;
+            return stats;
+        }
+    }
+
 #ifdef CROW_ENABLE_DEBUG
     static std::atomic<int> connectionCount;
 #endif
@@ -8827,17 +9639,19 @@ namespace crow
             Handler* handler, 
             const std::string& server_name,
             std::tuple<Middlewares...>* middlewares,
-            std::function<std::string()>& get_cached_date_str_f,
-            detail::dumb_timer_queue& timer_queue,
+            detail::cached_header_lines& header_lines,
+            detail::timer_wheel& timer_queue,
+            const detail::connection_timeouts& timeouts,
             typename Adaptor::context* adaptor_ctx_
             ) 
             : adaptor_(io_service, adaptor_ctx_), 
             handler_(handler), 
             parser_(this), 
             server_name_(server_name),
+            header_lines_(header_lines),
             middlewares_(middlewares),
-            get_cached_date_str(get_cached_date_str_f),
-            timer_queue(timer_queue)
+            timer_queue(timer_queue),
+            timeouts_(timeouts)
         {
 #ifdef CROW_ENABLE_DEBUG
             connectionCount ++;
@@ -8849,6 +9663,7 @@ namespace crow
         {
             res.complete_request_handler_ = nullptr;
             cancel_deadline_timer();
+            end_stream_wakeup();
 #ifdef CROW_ENABLE_DEBUG
             connectionCount --;
             CROW_LOG_DEBUG << "Connection closed, total " << connectionCount << ", " << this;
@@ -8865,7 +9680,13 @@ namespace crow
             adaptor_.start([this](const boost::system::error_code& ec) {
                 if (!ec)
                 {
-                    start_deadline();
+                    if (Adaptor::wait_for_readable)
+                    {
+                        boost::system::error_code ignored;
+                        adaptor_.raw_socket().non_blocking(true, ignored);
+                    }
+                    reading_message_ = true;
+                    start_deadline(timeouts_.read);
 
                     do_read();
                 }
@@ -8890,12 +9711,36 @@ namespace crow
 
         void handle()
         {
+            if (is_writing || need_to_call_after_handlers_ || chunk_source_)
+            {
+                // pipelined request: leave it in the parser until the response ahead of it is written
+                parser_.pause();
+                message_deferred_ = true;
+                return;
+            }
+
             cancel_deadline_timer();
             bool is_invalid_request = false;
             add_keep_alive_ = false;
+            allow_chunked_ = parser_.check_version(1, 1);
 
-            req_ = std::move(parser_.to_request());
+            parser_.to_request(req_);
             request& req = req_;
+            req.arena = nullptr;
+            {
+                boost::system::error_code ec;
+                auto endpoint = adaptor_.raw_socket().remote_endpoint(ec);
+                if (!ec)
+                    req.remote_ip_address = endpoint.address().to_string();
+                else
+                    req.remote_ip_address.clear();
+            }
+
+            // the next message starts with the smallest read buffer again
+            read_size_class_ = 0;
+            message_completed_ = true;
+            reading_message_ = false;
+            detail::get_read_buffer_stats().requests++;
 
             if (parser_.check_version(1, 0))
             {
@@ -8952,6 +9797,8 @@ namespace crow
                 ctx_ = detail::context<Middlewares...>();
                 req.middleware_context = (void*)&ctx_;
                 req.io_service = &adaptor_.get_io_service();
+                arena_.start();
+                req.arena = &arena_;
                 detail::middleware_call_helper<0, decltype(ctx_), decltype(*middlewares_), Middlewares...>(*middlewares_, req, res, ctx_);
 
                 if (!res.completed_)
@@ -8996,6 +9843,14 @@ namespace crow
             {
                 //CROW_LOG_DEBUG << this << " delete (socket is closed) " << is_reading << ' ' << is_writing;
                 //delete this;
+                if (need_to_start_read_after_complete_ || read_paused_ || (close_connection_ && !is_reading))
+                {
+                    // the handler outlived its deadline; no read is pending, so nothing else will free us
+                    need_to_start_read_after_complete_ = false;
+                    read_paused_ = false;
+                    is_reading = false;
+                    check_destroy();
+                }
                 return;
             }
 
@@ -9014,25 +9869,65 @@ namespace crow
                 {401, "HTTP/1.1 401 Unauthorized\r\n"},
                 {403, "HTTP/1.1 403 Forbidden\r\n"},
                 {404, "HTTP/1.1 404 Not Found\r\n"},
+                {409, "HTTP/1.1 409 Conflict\r\n"},
                 {422, "HTTP/1.1 422 Unprocessable Entity\r\n"},
+                {429, "HTTP/1.1 429 Too Many Requests\r\n"},
 
                 {500, "HTTP/1.1 500 Internal Server Error\r\n"},
                 {501, "HTTP/1.1 501 Not Implemented\r\n"},
                 {502, "HTTP/1.1 502 Bad Gateway\r\n"},
                 {503, "HTTP/1.1 503 Service Unavailable\r\n"},
+                {505, "HTTP/1.1 505 HTTP Version Not Supported\r\n"},
             };
 
             static std::string seperator = ": ";
             static std::string crlf = "\r\n";
 
             buffers_.clear();
-            buffers_.reserve(4*(res.headers.size()+5)+3);
+            buffers_.reserve(4*res.headers.size()+res.header_blocks_.size()+8);
 
-            if (res.body.empty() && res.json_value.t() == json::type::Object)
+            if (res.body.empty() && res.body_view_.empty() && res.json_value.t() == json::type::Object)
             {
                 res.body = json::dump(res.json_value);
             }
 
+            auto& stats = detail::get_response_write_stats();
+            if (res.event_source_)
+            {
+                if (allow_chunked_)
+                {
+                    // adapt the waiting source to the chunk pump; do_write_chunk() parks on an empty chunk
+                    stream_wakeup_ = std::make_shared<detail::stream_wakeup>();
+                    stream_wakeup_->io = &adaptor_.get_io_service();
+                    stream_wakeup_->resume = [this]{ resume_stream(); };
+                    stream_waker waker(stream_wakeup_);
+                    res.chunk_source_ = [source = std::move(res.event_source_), waker](std::string& chunk) {
+                        return source(chunk, waker);
+                    };
+                    stream_may_wait_ = true;
+                }
+                else
+                {
+                    res.code = 505;
+                    res.body.clear();
+                }
+                res.event_source_ = nullptr;
+            }
+            if (res.chunk_source_ && !allow_chunked_)
+            {
+                // HTTP/1.0 has no chunked encoding; collect the whole body instead
+                std::string chunk;
+                bool more = true;
+                while (more)
+                {
+                    chunk.clear();
+                    more = res.chunk_source_(chunk);
+                    res.body += chunk;
+                    stats.bytes_copied += chunk.size();
+                }
+                res.chunk_source_ = nullptr;
+            }
+
             if (!statusCodes.count(res.code))
                 res.code = 500;
             {
@@ -9040,9 +9935,15 @@ namespace crow
                 buffers_.emplace_back(status.data(), status.size());
             }
 
-            if (res.code >= 400 && res.body.empty())
+            if (res.code >= 400 && res.body.empty() && res.body_view_.empty())
                 res.body = statusCodes[res.code].substr(9);
 
+            // every head line is gathered straight from where it lives: static and
+            // per-thread encoded lines, header blocks and the header map; only the
+            // Content-Length digits are formatted per response
+            for(auto block : res.header_blocks_)
+                buffers_.emplace_back(block->encoded().data(), block->encoded().size());
+
             for(auto& kv : res.headers)
             {
                 buffers_.emplace_back(kv.first.data(), kv.first.size());
@@ -9052,46 +9953,76 @@ namespace crow
 
             }
 
-            if (!res.headers.count("content-length"))
+            if (res.chunk_source_)
             {
-                content_length_ = std::to_string(res.body.size());
-                static std::string content_length_tag = "Content-Length: ";
-                buffers_.emplace_back(content_length_tag.data(), content_length_tag.size());
-                buffers_.emplace_back(content_length_.data(), content_length_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                static std::string transfer_encoding_line = "Transfer-Encoding: chunked\r\n";
+                buffers_.emplace_back(transfer_encoding_line.data(), transfer_encoding_line.size());
             }
-            if (!res.headers.count("server"))
+            else if (!res.has_header("content-length"))
             {
-                static std::string server_tag = "Server: ";
-                buffers_.emplace_back(server_tag.data(), server_tag.size());
-                buffers_.emplace_back(server_name_.data(), server_name_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                static const char content_length_tag[] = "Content-Length: ";
+                const size_t tag_size = sizeof(content_length_tag) - 1;
+                std::copy(content_length_tag, content_length_tag + tag_size, content_length_line_);
+                char* end = content_length_line_ + tag_size;
+                size_t length = res.body_view_.empty() ? res.body.size() : res.body_view_.size();
+                char digits[24];
+                char* d = digits + sizeof(digits);
+                do
+                {
+                    *--d = char('0' + length % 10);
+                    length /= 10;
+                } while (length);
+                end = std::copy(d, digits + sizeof(digits), end);
+                *end++ = '\r';
+                *end++ = '\n';
+                content_length_line_size_ = end - content_length_line_;
+                buffers_.emplace_back(content_length_line_, content_length_line_size_);
+                stats.bytes_copied += content_length_line_size_;
             }
-            if (!res.headers.count("date"))
+            if (!res.has_header("server"))
             {
-                static std::string date_tag = "Date: ";
-                date_str_ = get_cached_date_str();
-                buffers_.emplace_back(date_tag.data(), date_tag.size());
-                buffers_.emplace_back(date_str_.data(), date_str_.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                auto& server_line = header_lines_.server();
+                buffers_.emplace_back(server_line.data(), server_line.size());
+            }
+            if (!res.has_header("date"))
+            {
+                auto& date_line = header_lines_.date();
+                buffers_.emplace_back(date_line.data(), date_line.size());
             }
             if (add_keep_alive_)
             {
-                static std::string keep_alive_tag = "Connection: Keep-Alive";
-                buffers_.emplace_back(keep_alive_tag.data(), keep_alive_tag.size());
-                buffers_.emplace_back(crlf.data(), crlf.size());
+                static std::string keep_alive_line = "Connection: Keep-Alive\r\n";
+                buffers_.emplace_back(keep_alive_line.data(), keep_alive_line.size());
             }
 
             buffers_.emplace_back(crlf.data(), crlf.size());
-            res_body_copy_.swap(res.body);
-            buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+            stats.responses++;
+            stats.head_bytes += boost::asio::buffer_size(buffers_);
+            if (res.chunk_source_)
+            {
+                chunk_source_ = std::move(res.chunk_source_);
+                res.chunk_source_ = nullptr;
+                streaming_ = true;
+            }
+            else if (!res.body_view_.empty())
+            {
+                // stays in the request arena until the write below has finished
+                buffers_.emplace_back(res.body_view_.data(), res.body_view_.size());
+                stats.body_bytes += res.body_view_.size();
+            }
+            else
+            {
+                res_body_copy_.swap(res.body);
+                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                stats.body_bytes += res_body_copy_.size();
+            }
 
             do_write();
 
             if (need_to_start_read_after_complete_)
             {
                 need_to_start_read_after_complete_ = false;
-                start_deadline();
+                start_idle_deadline();
                 do_read();
             }
         }
@@ -9101,19 +10032,69 @@ namespace crow
         {
             //auto self = this->shared_from_this();
             is_reading = true;
-            adaptor_.socket().async_read_some(boost::asio::buffer(buffer_), 
-                [this](const boost::system::error_code& ec, std::size_t bytes_transferred)
-                {
+            if (Adaptor::wait_for_readable)
+            {
+                // wait for data without holding a buffer; idle keep-alive
+                // connections therefore cost only the Connection object
+                adaptor_.raw_socket().async_wait(tcp::socket::wait_read,
+                    [this](const boost::system::error_code& ec)
+                    {
+                        if (ec)
+                        {
+                            on_read(ec, 0);
+                            return;
+                        }
+
+                        boost::system::error_code read_ec;
+                        buffer_ = detail::pooled_buffer(read_size_class_);
+                        std::size_t bytes_transferred = adaptor_.socket().read_some(boost::asio::buffer(buffer_.data(), buffer_.size()), read_ec);
+                        if (read_ec == boost::asio::error::would_block || read_ec == boost::asio::error::try_again)
+                        {
+                            buffer_.release();
+                            do_read();
+                            return;
+                        }
+                        on_read(read_ec, bytes_transferred);
+                    });
+            }
+            else
+            {
+                buffer_ = detail::pooled_buffer(read_size_class_);
+                adaptor_.socket().async_read_some(boost::asio::buffer(buffer_.data(), buffer_.size()), 
+                    [this](const boost::system::error_code& ec, std::size_t bytes_transferred)
+                    {
+                        on_read(ec, bytes_transferred);
+                    });
+            }
+        }
+
+        void on_read(const boost::system::error_code& ec, std::size_t bytes_transferred)
+        {
                     bool error_while_reading = true;
                     if (!ec)
                     {
+                        detail::get_read_buffer_stats().reads++;
+                        bool filled = bytes_transferred == buffer_.size();
+                        message_completed_ = false;
                         bool ret = parser_.feed(buffer_.data(), bytes_transferred);
+                        if (ret && parser_.is_paused())
+                            pending_input_.assign(buffer_.data() + parser_.consumed, bytes_transferred - parser_.consumed);
+                        // a full buffer that did not finish a message means a large
+                        // body; use a bigger buffer so it takes fewer reads
+                        if (filled && !message_completed_ && read_size_class_ + 1 < detail::read_buffer_pool::size_classes)
+                            read_size_class_++;
                         if (ret && adaptor_.is_open())
                         {
                             error_while_reading = false;
                         }
                     }
+                    buffer_.release();
+                    after_input(error_while_reading);
+        }
 
+        // decides what the connection does once a batch of input has gone through the parser
+        void after_input(bool error_while_reading)
+        {
                     if (error_while_reading)
                     {
                         cancel_deadline_timer();
@@ -9128,20 +10109,69 @@ namespace crow
                         cancel_deadline_timer();
                         parser_.done();
                         is_reading = false;
+                        if (need_to_call_after_handlers_)
+                        {
+                            // the response is still owed; complete_request() frees us once it is written
+                            start_deadline(timeouts_.handler);
+                            return;
+                        }
                         check_destroy();
                         // adaptor will close after write
                     }
+                    else if (parser_.is_paused())
+                    {
+                        // a pipelined request is waiting; no more reads until resume_pipeline()
+                        is_reading = false;
+                        read_paused_ = true;
+                    }
                     else if (!need_to_call_after_handlers_)
                     {
-                        start_deadline();
+                        if (message_completed_)
+                        {
+                            // between requests; bytes of the next one restart the read deadline below
+                            start_idle_deadline();
+                        }
+                        else if (!reading_message_)
+                        {
+                            // the read deadline covers the whole request, not each read
+                            reading_message_ = true;
+                            start_deadline(timeouts_.read);
+                        }
                         do_read();
                     }
                     else
                     {
                         // res will be completed later by user
                         need_to_start_read_after_complete_ = true;
+                        start_deadline(timeouts_.handler);
                     }
-                });
+        }
+
+        // called when a response has been written while a pipelined request was waiting:
+        // handles that request, then parses the input that followed it
+        void resume_pipeline()
+        {
+            read_paused_ = false;
+            is_reading = true;
+            parser_.resume();
+            message_completed_ = false;
+            if (message_deferred_)
+            {
+                message_deferred_ = false;
+                handle();
+            }
+
+            bool ret = true;
+            if (!pending_input_.empty())
+            {
+                resume_input_.swap(pending_input_);
+                pending_input_.clear();
+                ret = parser_.feed(resume_input_.data(), resume_input_.size());
+                if (ret && parser_.is_paused())
+                    pending_input_.assign(resume_input_, parser_.consumed, std::string::npos);
+                resume_input_.clear();
+            }
+            after_input(!ret || !adaptor_.is_open());
         }
 
         void do_write()
@@ -9152,8 +10182,20 @@ namespace crow
                 [&](const boost::system::error_code& ec, std::size_t /*bytes_transferred*/)
                 {
                     is_writing = false;
+                    if (!ec && chunk_source_)
+                    {
+                        do_write_chunk();
+                        return;
+                    }
+                    chunk_source_ = nullptr;
+                    end_stream_wakeup();
+                    bool stream_ended = streaming_;
+                    streaming_ = false;
                     res.clear();
                     res_body_copy_.clear();
+                    // the response is written; a 100 Continue can also end up here while a handler is still running
+                    if (!need_to_call_after_handlers_)
+                        arena_.reset();
                     if (!ec)
                     {
                         if (close_connection_)
@@ -9162,6 +10204,15 @@ namespace crow
                             CROW_LOG_DEBUG << this << " from write(1)";
                             check_destroy();
                         }
+                        else if (read_paused_)
+                        {
+                            resume_pipeline();
+                        }
+                        else if (stream_ended && is_reading)
+                        {
+                            // the idle deadline was held off while the stream was being written
+                            start_idle_deadline();
+                        }
                     }
                     else
                     {
@@ -9171,6 +10222,85 @@ namespace crow
                 });
         }
 
+        void do_write_chunk()
+        {
+            static std::string crlf = "\r\n";
+            static std::string last_chunk = "0\r\n\r\n";
+
+            bool more = false;
+            chunk_.clear();
+            try
+            {
+                more = chunk_source_(chunk_);
+            }
+            catch(std::exception& e)
+            {
+                // the response is already under way; end it without the last chunk so the client sees the error
+                CROW_LOG_ERROR << "An uncaught exception occurred while streaming: " << e.what();
+                chunk_source_ = nullptr;
+                close_connection_ = true;
+                buffers_.clear();
+                do_write();
+                return;
+            }
+
+            if (chunk_.empty() && more && stream_may_wait_)
+            {
+                // nothing to send yet; the source's waker calls resume_stream()
+                stream_parked_ = true;
+                return;
+            }
+
+            buffers_.clear();
+            if (!chunk_.empty())
+            {
+                char size_line[20];
+                int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", chunk_.size());
+                chunk_size_line_.assign(size_line, n);
+                buffers_.emplace_back(chunk_size_line_.data(), chunk_size_line_.size());
+                buffers_.emplace_back(chunk_.data(), chunk_.size());
+                buffers_.emplace_back(crlf.data(), crlf.size());
+            }
+            if (!more)
+            {
+                chunk_source_ = nullptr;
+                buffers_.emplace_back(last_chunk.data(), last_chunk.size());
+            }
+            do_write();
+        }
+
+        void resume_stream()
+        {
+            if (!stream_parked_)
+                return;
+            stream_parked_ = false;
+            if (chunk_source_ && adaptor_.is_open())
+                do_write_chunk();
+        }
+
+        void end_stream_wakeup()
+        {
+            stream_may_wait_ = false;
+            stream_parked_ = false;
+            if (!stream_wakeup_)
+                return;
+            {
+                std::lock_guard<std::mutex> lock(stream_wakeup_->mutex);
+                stream_wakeup_->io = nullptr;
+            }
+            stream_wakeup_->resume = nullptr;
+            stream_wakeup_.reset();
+        }
+
+        // a response stream may run far longer than the idle timeout; its deadline starts once it is written
+        void start_idle_deadline()
+        {
+            if (streaming_)
+                cancel_deadline_timer();
+            else
+                start_deadline(timeouts_.idle);
+        }
+
         void check_destroy()
         {
             CROW_LOG_DEBUG << this << " is_reading " << is_reading << " is_writing " << is_writing;
@@ -9187,9 +10317,11 @@ namespace crow
             timer_queue.cancel(timer_cancel_key_);
         }
 
-        void start_deadline(/*int timeout = 5*/)
+        void start_deadline(std::chrono::milliseconds timeout)
         {
             cancel_deadline_timer();
+            if (timeout.count() <= 0)
+                return;
             
             timer_cancel_key_ = timer_queue.add([this]
             {
@@ -9198,7 +10330,7 @@ namespace crow
                     return;
                 }
                 adaptor_.close();
-            });
+            }, timeout);
             CROW_LOG_DEBUG << this << " timer added: " << timer_cancel_key_.first << ' ' << timer_cancel_key_.second;
         }
 
@@ -9206,7 +10338,14 @@ namespace crow
         Adaptor adaptor_;
         Handler* handler_;
 
-        boost::array<char, 4096> buffer_;
+        detail::pooled_buffer buffer_;
+        unsigned read_size_class_{};
+        bool message_completed_{};
+        bool reading_message_{};
+        bool message_deferred_{};
+        bool read_paused_{};
+        std::string pending_input_;
+        std::string resume_input_;
 
         HTTPParser<Connection> parser_;
         request req_;
@@ -9215,26 +10354,37 @@ namespace crow
         bool close_connection_ = false;
 
         const std::string& server_name_;
+        detail::cached_header_lines& header_lines_;
         std::vector<boost::asio::const_buffer> buffers_;
 
-        std::string content_length_;
-        std::string date_str_;
+        char content_length_line_[48];
+        size_t content_length_line_size_{};
         std::string res_body_copy_;
 
+        std::function<bool(std::string&)> chunk_source_;
+        std::string chunk_;
+        std::string chunk_size_line_;
+        bool streaming_{};
+        bool stream_may_wait_{};
+        bool stream_parked_{};
+        std::shared_ptr<detail::stream_wakeup> stream_wakeup_;
+
         //boost::asio::deadline_timer deadline_;
-        detail::dumb_timer_queue::key timer_cancel_key_;
+        detail::timer_wheel::key timer_cancel_key_;
 
         bool is_reading{};
         bool is_writing{};
         bool need_to_call_after_handlers_{};
         bool need_to_start_read_after_complete_{};
         bool add_keep_alive_{};
+        bool allow_chunked_{};
 
         std::tuple<Middlewares...>* middlewares_;
         detail::context<Middlewares...> ctx_;
+        request_arena arena_;
 
-        std::function<std::string()>& get_cached_date_str;
-        detail::dumb_timer_queue& timer_queue;
+        detail::timer_wheel& timer_queue;
+        const detail::connection_timeouts& timeouts_;
     };
 
 }
@@ -9253,6 +10403,10 @@ namespace crow
 #include <atomic>
 #include <future>
 #include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <memory>
 
@@ -9273,7 +10427,7 @@ namespace crow
     {
     public:
     Server(Handler* handler, std::string bindaddr, uint16_t port, std::tuple<Middlewares...>* middlewares = nullptr, uint16_t concurrency = 1, typename Adaptor::context* adaptor_ctx = nullptr)
-            : acceptor_(io_service_, tcp::endpoint(boost::asio::ip::address::from_string(bindaddr), port)),
+            : acceptor_(io_service_),
             signals_(io_service_, SIGINT, SIGTERM),
             tick_timer_(io_service_),
             handler_(handler),
@@ -9291,6 +10445,18 @@ namespace crow
             tick_function_ = f;
         }
 
+        void set_timeouts(const detail::connection_timeouts& timeouts)
+        {
+            timeouts_ = timeouts;
+        }
+
+        // One SO_REUSEPORT listener per worker, with each worker pinned to a core.
+        // Only takes effect on Linux; elsewhere the shared acceptor is used.
+        void set_reuse_port(bool reuse_port)
+        {
+            reuse_port_ = reuse_port;
+        }
+
         void on_tick()
         {
             tick_function_();
@@ -9310,58 +10476,69 @@ namespace crow
 
             for(int i = 0; i < concurrency_;  i++)
                 io_service_pool_.emplace_back(new boost::asio::io_service());
-            get_cached_date_str_pool_.resize(concurrency_);
+            header_lines_pool_.resize(concurrency_);
             timer_queue_pool_.resize(concurrency_);
 
+            tcp::endpoint endpoint(boost::asio::ip::address::from_string(bindaddr_), port_);
+#ifdef __linux__
+            bool per_worker_acceptors = reuse_port_;
+#else
+            bool per_worker_acceptors = false;
+            if (reuse_port_)
+                CROW_LOG_WARNING << "reuse_port is only supported on Linux; using a shared acceptor";
+#endif
+            std::vector<int> cpus;
+            if (per_worker_acceptors)
+            {
+                // bound here so a failure to bind surfaces from run()
+                for(uint16_t i = 0; i < concurrency_; i ++)
+                {
+                    worker_acceptors_.emplace_back(new tcp::acceptor(*io_service_pool_[i]));
+                    open_acceptor(*worker_acceptors_.back(), endpoint, true);
+                }
+                cpus = detail::cpus_by_numa_node();
+            }
+            else
+            {
+                open_acceptor(acceptor_, endpoint, false);
+            }
+
             std::vector<std::future<void>> v;
             std::atomic<int> init_count(0);
             for(uint16_t i = 0; i < concurrency_; i ++)
                 v.push_back(
-                        std::async(std::launch::async, [this, i, &init_count]{
-
-                            // thread local date string get function
-                            auto last = std::chrono::steady_clock::now();
-
-                            std::string date_str;
-                            auto update_date_str = [&]
+                        std::async(std::launch::async, [this, i, &init_count, &cpus]{
+#ifdef __linux__
+                            if (!cpus.empty())
                             {
-                                auto last_time_t = time(0);
-                                tm my_tm;
-
-#ifdef _MSC_VER
-                                gmtime_s(&my_tm, &last_time_t);
-#else
-                                gmtime_r(&last_time_t, &my_tm);
+                                // consecutive workers fill one NUMA node before the next
+                                cpu_set_t cpu_set;
+                                CPU_ZERO(&cpu_set);
+                                CPU_SET(cpus[i % cpus.size()], &cpu_set);
+                                if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+                                    CROW_LOG_WARNING << "could not pin worker " << i << " to cpu " << cpus[i % cpus.size()];
+                            }
 #endif
-                                date_str.resize(100);
-                                size_t date_str_sz = strftime(&date_str[0], 99, "%a, %d %b %Y %H:%M:%S GMT", &my_tm);
-                                date_str.resize(date_str_sz);
-                            };
-                            update_date_str();
-                            get_cached_date_str_pool_[i] = [&]()->std::string
-                            {
-                                if (std::chrono::steady_clock::now() - last >= std::chrono::seconds(1))
-                                {
-                                    last = std::chrono::steady_clock::now();
-                                    update_date_str();
-                                }
-                                return date_str;
-                            };
 
-                            // initializing timer queue
-                            detail::dumb_timer_queue timer_queue;
+                            // Server and Date lines for this thread's connections
+                            detail::cached_header_lines header_lines(server_name_);
+                            header_lines_pool_[i] = &header_lines;
+
+                            // initializing timer queue; it advances once per granularity tick
+                            detail::timer_wheel timer_queue(timeouts_.granularity);
                             timer_queue_pool_[i] = &timer_queue;
 
                             timer_queue.set_io_service(*io_service_pool_[i]);
+                            auto tick = boost::posix_time::milliseconds(timer_queue.granularity().count());
                             boost::asio::deadline_timer timer(*io_service_pool_[i]);
-                            timer.expires_from_now(boost::posix_time::seconds(1));
+                            timer.expires_from_now(tick);
 
                             std::function<void(const boost::system::error_code& ec)> handler;
                             handler = [&](const boost::system::error_code& ec){
                                 if (ec)
                                     return;
                                 timer_queue.process();
-                                timer.expires_from_now(boost::posix_time::seconds(1));
+                                timer.expires_from_now(tick);
                                 timer.async_wait(handler);
                             };
                             timer.async_wait(handler);
@@ -9395,7 +10572,7 @@ namespace crow
             }
 
             CROW_LOG_INFO << server_name_ << " server is running at " << bindaddr_ <<":" << port_
-                          << " using " << concurrency_ << " threads";
+                          << " using " << concurrency_ << " threads (" << detail::network_backend() << ")";
             CROW_LOG_INFO << "Call `app.loglevel(crow::LogLevel::Warning)` to hide Info level logs.";
 
             signals_.async_wait(
@@ -9406,7 +10583,14 @@ namespace crow
             while(concurrency_ != init_count)
                 std::this_thread::yield();
 
-            do_accept();
+            if (per_worker_acceptors)
+            {
+                CROW_LOG_INFO << "Accepting on " << concurrency_ << " SO_REUSEPORT listeners";
+                for(uint16_t i = 0; i < concurrency_; i ++)
+                    do_accept_on(i);
+            }
+            else
+                do_accept();
 
             std::thread([this]{
                 io_service_.run();
@@ -9422,6 +10606,18 @@ namespace crow
         }
 
     private:
+        void open_acceptor(tcp::acceptor& acceptor, const tcp::endpoint& endpoint, bool reuse_port)
+        {
+            acceptor.open(endpoint.protocol());
+            acceptor.set_option(tcp::acceptor::reuse_address(true));
+#ifdef __linux__
+            if (reuse_port)
+                acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+            acceptor.bind(endpoint);
+            acceptor.listen();
+        }
+
         asio::io_service& pick_io_service()
         {
             // TODO load balancing
@@ -9436,8 +10632,8 @@ namespace crow
             asio::io_service& is = pick_io_service();
             auto p = new Connection<Adaptor, Handler, Middlewares...>(
                 is, handler_, server_name_, middlewares_,
-                get_cached_date_str_pool_[roundrobin_index_], *timer_queue_pool_[roundrobin_index_],
-                adaptor_ctx_);
+                *header_lines_pool_[roundrobin_index_], *timer_queue_pool_[roundrobin_index_],
+                timeouts_, adaptor_ctx_);
             acceptor_.async_accept(p->socket(),
                 [this, p, &is](boost::system::error_code ec)
                 {
@@ -9456,11 +10652,32 @@ namespace crow
                 });
         }
 
+        // accept loop of worker i in reuse_port mode; the kernel picks the listener,
+        // and the connection stays on the thread that accepted it
+        void do_accept_on(uint16_t i)
+        {
+            auto p = new Connection<Adaptor, Handler, Middlewares...>(
+                *io_service_pool_[i], handler_, server_name_, middlewares_,
+                *header_lines_pool_[i], *timer_queue_pool_[i],
+                timeouts_, adaptor_ctx_);
+            worker_acceptors_[i]->async_accept(p->socket(),
+                [this, p, i](boost::system::error_code ec)
+                {
+                    if (!ec)
+                        p->start();
+                    else
+                        delete p;
+                    if (ec != boost::asio::error::operation_aborted)
+                        do_accept_on(i);
+                });
+        }
+
     private:
         asio::io_service io_service_;
         std::vector<std::unique_ptr<asio::io_service>> io_service_pool_;
-        std::vector<detail::dumb_timer_queue*> timer_queue_pool_;
-        std::vector<std::function<std::string()>> get_cached_date_str_pool_;
+        std::vector<detail::timer_wheel*> timer_queue_pool_;
+        std::vector<std::unique_ptr<tcp::acceptor>> worker_acceptors_;
+        std::vector<detail::cached_header_lines*> header_lines_pool_;
         tcp::acceptor acceptor_;
         boost::asio::signal_set signals_;
         boost::asio::deadline_timer tick_timer_;
@@ -9474,6 +10691,8 @@ namespace crow
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
+        detail::connection_timeouts timeouts_;
+        bool reuse_port_{};
 
         std::tuple<Middlewares...>* middlewares_;
 
@@ -9586,6 +10805,36 @@ namespace crow
             return *this;
         }
 
+        self_t& reuse_port(bool enabled = true)
+        {
+            reuse_port_ = enabled;
+            return *this;
+        }
+
+        self_t& idle_timeout(std::chrono::milliseconds timeout)
+        {
+            timeouts_.idle = timeout;
+            return *this;
+        }
+
+        self_t& read_timeout(std::chrono::milliseconds timeout)
+        {
+            timeouts_.read = timeout;
+            return *this;
+        }
+
+        self_t& handler_timeout(std::chrono::milliseconds timeout)
+        {
+            timeouts_.handler = timeout;
+            return *this;
+        }
+
+        self_t& timer_granularity(std::chrono::milliseconds granularity)
+        {
+            timeouts_.granularity = granularity;
+            return *this;
+        }
+
         void validate()
         {
             router_.validate();
@@ -9599,6 +10848,8 @@ namespace crow
             {
                 ssl_server_ = std::move(std::unique_ptr<ssl_server_t>(new ssl_server_t(this, bindaddr_, port_, &middlewares_, concurrency_, &ssl_context_)));
                 ssl_server_->set_tick_function(tick_interval_, tick_function_);
+                ssl_server_->set_timeouts(timeouts_);
+                ssl_server_->set_reuse_port(reuse_port_);
                 ssl_server_->run();
             }
             else
@@ -9606,6 +10857,8 @@ namespace crow
             {
                 server_ = std::move(std::unique_ptr<server_t>(new server_t(this, bindaddr_, port_, &middlewares_, concurrency_, nullptr)));
                 server_->set_tick_function(tick_interval_, tick_function_);
+                server_->set_timeouts(timeouts_);
+                server_->set_reuse_port(reuse_port_);
                 server_->run();
             }
         }
@@ -9730,6 +10983,8 @@ namespace crow
 
         std::chrono::milliseconds tick_interval_;
         std::function<void()> tick_function_;
+        detail::connection_timeouts timeouts_;
+        bool reuse_port_{};
 
         std::tuple<Middlewares...> middlewares_;
 
@@ -10,6 +10,13 @@
 */
 
 #include "Account.h"
+#include "ModelJson.h"
+#include "AsyncLogger.h"
+#include "BalanceFeed.h"
+#include "Journal.h"
+#include "AccountEvents.h"
+
+#include <cmath>
 
 using namespace std;
 
@@ -40,6 +47,18 @@ int Account::getAccountID() const {
     return accountID;
 }
 
+/**
+* @brief Returns the ID of the user that owns the account.
+*
+* getUserID():
+* A Getter function that returns the user ID that this account belongs to.
+*
+* @return userID The account's user ID
+*/
+int Account::getUserID() const {
+    return userID;
+}
+
 /**
 * @brief Sets the account's ID to a different ID
 *
@@ -105,11 +124,22 @@ void Account::setAccountType(string newType) {
 *
 * deposit():
 * A function that deposits a specified amount of money to the account's balance.
+* The deposit is posted to the journal against the external account, and the balance becomes the journal's projection.
+* A Deposited event is then appended to the account's event stream. Amounts that are not a positive number of cents are refused before anything is posted.
 *
 * @param amount The amount to be deposited
 */
 void Account::deposit(double amount) {
-    balance += amount;
+    if (!isValidAmount(amount)) {
+        // Frontend: Display on screen "Please enter an amount greater than zero."
+        return;
+    }
+
+    Journal& journal = Journal::instance();
+    openLedgers();
+    journal.post(Journal::deposit(accountID, amount));
+    balance = journal.balance(accountID);
+    AccountEvents::instance().deposited(accountID, amount);
 }
 
 /**
@@ -117,19 +147,30 @@ void Account::deposit(double amount) {
 *
 * withdraw():
 * A function that withdraws a specified amount of money from the account's balance, making sure that the account has sufficient funds before withdrawing the amount.
+* The withdrawal is posted to the journal, which checks the funds again as it commits, and a Withdrawn event is appended once it succeeds.
+* Amounts that are not a positive number of cents are refused before anything is posted.
 *
 * @param amount The amount to be withdrawn
 */
 void Account::withdraw(double amount) {
+    if (!isValidAmount(amount)) {
+        // Frontend: Display on screen "Please enter an amount greater than zero."
+        return;
+    }
+
+    Journal& journal = Journal::instance();
+    openLedgers();
+    balance = journal.balance(accountID);
 
     // If the amount being withdrawn is not within the account's available balance:
-    if (amount > balance) {
+    if (!StandardPolicy::allowsWithdrawal(amount, balance) || journal.post(Journal::withdrawal(accountID, amount)) == 0) {
         
         // Frontend: Display on screen "Insufficient Funds. Please enter a lower withdrawal amount."
     }
 
     else {
-        balance -= amount; // Deduct the amount being withdrawn from the account's balance if it is less than or equal to the account's balance
+        balance = journal.balance(accountID); // The account's balance after the withdrawal was posted
+        AccountEvents::instance().withdrawn(accountID, amount);
     }
 }
 
@@ -139,28 +180,107 @@ void Account::withdraw(double amount) {
 * transfer():
 * A function that transfers a specified amount of money from one account to another.
 * It makes sure that the account has sufficient funds before transferring the amount.
+* Both sides are posted to the journal as one balanced entry, so money is never created or lost halfway through a transfer.
+* A single Transferred event records it in both accounts' event streams.
 *
 * @param recipient A reference to the recipient's Account object
 * @param amount The amount to be transferred
+* @return True if the transfer was posted, false if the amount was not positive or the account had insufficient funds
 */
-void Account::transfer(Account& recipient, double amount) {
+bool Account::transfer(Account& recipient, double amount) {
+    if (!isValidAmount(amount)) {
+        // Frontend: Display on screen "Please enter an amount greater than zero."
+        return false;
+    }
+
+    Journal& journal = Journal::instance();
+    openLedgers();
+    recipient.openLedgers();
+    balance = journal.balance(accountID);
 
-    // If the amount being transferred is within the account's available balance:
-    if (amount <= balance) {
+    // If the amount being transferred is within the account's available balance (checked again by the journal as it commits):
+    if (amount <= balance && journal.post(Journal::transfer(accountID, recipient.accountID, amount)) != 0) {
 
-        // Deposit the transfer amount to the recipient's account and deduct the transfer amount from the sender's account 
-        recipient.deposit(amount);
-        balance -= amount;
+        // Both balances are the journal's projections after the entry was posted
+        balance = journal.balance(accountID);
+        recipient.balance = journal.balance(recipient.accountID);
+        AccountEvents::instance().transferred(accountID, recipient.accountID, amount);
+        return true;
     }
 
     else {
         // Frontend: Display on screen "Insufficient Funds. Please enter a lower transfer amount."
-        cout << "Insufficient Funds" << endl;
+        AsyncLogger::instance().log(AsyncLogger::Level::Info, "transfer.insufficient_funds", { { "accountID", accountID }, { "recipientID", recipient.accountID }, { "amount", amount }, { "balance", balance } });
+        return false;
     }
 }
 
+/**
+* @brief Publishes the account's balance to the balance feed
+*
+* publishBalance():
+* A function that publishes the account's current balance to WebSocket subscribers and the in-memory balance readers.
+* Deposits, withdrawals, and transfers do not publish on their own, so call this once the change has been saved.
+*/
+void Account::publishBalance() const {
+    BalanceFeed::instance().publish(accountID, balance);
+}
+
+/**
+* @brief Returns the account's information as a JSON object.
+*
+* toJson():
+* A function that writes the account's ID, balance, user ID, and type into a JSON string using the field description in 'ModelJson.h'.
+*
+* @return The account as a JSON string
+*/
+string Account::toJson() const {
+    return toJsonString(*this);
+}
+
+/**
+* @brief Returns an account by its ID
+*
+* fetchAccount():
+* A function that rebuilds an account from the projection of its event stream.
+* Accounts without events yet fall back to a placeholder until accounts are stored in the database.
+*
+* @param accountID The account's ID
+* @return The account
+*/
 Account Account::fetchAccount(int accountID) {
+    AccountEvents::State state;
+    if (AccountEvents::instance().find(accountID, state)) {
+        return Account(accountID, Journal::fromCents(state.balanceCents), state.userID, AccountEvents::accountType(state.kind));
+    }
+
     // Fetch account data from the database
     // For now, return a dummy account
     return Account(accountID, 1000.0, 1, "Savings");
 }
+
+/**
+* @brief Brings the account into the journal and the event stream
+*
+* openLedgers():
+* A function that opens the account in the journal and appends its Opened event, both with the balance the account was loaded with.
+* Both do nothing if they already know the account, so it is called before every change.
+*/
+void Account::openLedgers() {
+    Journal::instance().open(accountID, balance);
+    AccountEvents::instance().open(accountID, userID, AccountEvents::kindOf(accountType), balance);
+}
+
+/**
+* @brief Checks that an amount can be posted to the journal
+*
+* isValidAmount():
+* A function that checks that an amount is a finite number that rounds to at least one cent.
+* The journal throws on any other amount, so deposits, withdrawals, and transfers check it before posting.
+*
+* @param amount The amount to be checked
+* @return True if the amount is a positive number of cents, false otherwise
+*/
+bool Account::isValidAmount(double amount) {
+    return std::isfinite(amount) && Journal::toCents(amount) > 0;
+}
@@ -0,0 +1,358 @@
+/**
+* Author: Group 13
+* Date: 28/3/2025
+*
+* @brief Groups many accounts by their kind and applies withdrawals and interest to each group in one loop, posting the results through the journal and the event stream.
+*
+* AccountBatch.cpp:
+* This file handles batches of accounts. Each kind of account ("Account", "CheckingsAccount", and "SavingsAccount") has its own lane, and each lane is checked with its own policy from 'AccountPolicy.h'.
+* A withdrawal in a batch follows the same rules as calling 'withdraw' on the account itself: the policy is checked against the journal's balance, the journal checks the funds again as it commits,
+* and a Withdrawn event is appended once it succeeds. The difference is that the withdrawals of a lane share journal entries instead of each posting its own.
+*/
+
+#include "AccountBatch.h"
+#include "Journal.h"
+#include "AccountEvents.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    // Commit() nets the legs of each account against each other, so a lane's withdrawals are split over entries of this many legs
+    constexpr size_t kLegsPerEntry = 64;
+}
+
+/**
+* @brief Adds an account to the end of a lane
+*
+* push():
+* A function that stores the account's information in the lane's arrays together with the policy that checks its withdrawals.
+*
+* @param account The account to be added
+* @param policy The account's withdrawal policy
+*/
+template <typename Policy>
+void AccountBatch::Lane<Policy>::push(const Account& account, Policy policy) {
+    accountIDs.push_back(account.getAccountID());
+    userIDs.push_back(account.getUserID());
+    accountTypes.push_back(account.getAccountType());
+    balanceCents.push_back(Journal::toCents(Journal::instance().balance(account.getAccountID())));
+    policies.push_back(policy);
+}
+
+/**
+* @brief Claims an account's ID for the batch
+*
+* reserve():
+* A function that records where the account lives in the batch and brings it into the journal and the event stream, the same way 'Account' does before its first change.
+* An ID that is already in the batch is refused, so an account can only ever be in one lane once.
+*
+* @param account The account being added
+* @param kind The lane that the account goes into
+* @param index The account's position in that lane
+* @return true if the account was not in the batch yet
+*/
+bool AccountBatch::reserve(const Account& account, Kind kind, size_t index) {
+    if (!slots.emplace(account.getAccountID(), Slot{ kind, index }).second) {
+        return false;
+    }
+    Journal::instance().open(account.getAccountID(), account.getBalance());
+    AccountEvents::instance().open(account.getAccountID(), account.getUserID(), AccountEvents::kindOf(account.getAccountType()), account.getBalance());
+    return true;
+}
+
+/**
+* @brief Adds a plain account to the batch
+*
+* add():
+* A function that adds a plain account to the batch's Standard lane.
+*
+* @param account The account to be added
+* @return false if the batch already has an account with the same ID
+*/
+bool AccountBatch::add(const Account& account) {
+    if (!reserve(account, Kind::Standard, standard.accountIDs.size())) {
+        return false;
+    }
+    standard.push(account, StandardPolicy{});
+    return true;
+}
+
+/**
+* @brief Adds a Checkings Account to the batch
+*
+* add():
+* A function that adds a Checkings Account to the batch's Checkings lane together with its withdrawal limit.
+*
+* @param account The Checkings Account to be added
+* @return false if the batch already has an account with the same ID
+*/
+bool AccountBatch::add(const CheckingsAccount& account) {
+    if (!reserve(account, Kind::Checkings, checkings.accountIDs.size())) {
+        return false;
+    }
+    checkings.push(account, account.getPolicy());
+    return true;
+}
+
+/**
+* @brief Adds a Savings Account to the batch
+*
+* add():
+* A function that adds a Savings Account to the batch's Savings lane.
+*
+* @param account The Savings Account to be added
+* @return false if the batch already has an account with the same ID
+*/
+bool AccountBatch::add(const SavingsAccount& account) {
+    if (!reserve(account, Kind::Savings, savings.accountIDs.size())) {
+        return false;
+    }
+    savings.push(account, SavingsPolicy{});
+    return true;
+}
+
+/**
+* @brief Adds an account of any kind to the batch
+*
+* add():
+* A function that adds the account held by the variant to the lane of its kind.
+*
+* @param account The account to be added
+* @return false if the batch already has an account with the same ID
+*/
+bool AccountBatch::add(const AnyAccount& account) {
+    return visit([this](const auto& held) { return add(held); }, account);
+}
+
+/**
+* @brief Returns the number of accounts in the batch.
+*
+* size():
+* A Getter function that returns the number of accounts across every lane.
+*
+* @return The number of accounts in the batch
+*/
+size_t AccountBatch::size() const {
+    return slots.size();
+}
+
+/**
+* @brief Checks if an account is in the batch
+*
+* contains():
+* A function that checks if an account with the given ID has been added to the batch.
+*
+* @param accountID The account's ID
+* @return true if the account is in the batch
+*/
+bool AccountBatch::contains(int accountID) const {
+    return slots.count(accountID) != 0;
+}
+
+/**
+* @brief Returns the balance of an account in the batch.
+*
+* getBalance():
+* A Getter function that returns the account's balance as of the last batch operation, or 0 if the account is not in the batch.
+*
+* @param accountID The account's ID
+* @return The account's balance
+*/
+double AccountBatch::getBalance(int accountID) const {
+    const auto slot = slots.find(accountID);
+    if (slot == slots.end()) {
+        return 0.0;
+    }
+    switch (slot->second.kind) {
+    case Kind::Checkings:
+        return Journal::fromCents(checkings.balanceCents[slot->second.index]);
+    case Kind::Savings:
+        return Journal::fromCents(savings.balanceCents[slot->second.index]);
+    default:
+        return Journal::fromCents(standard.balanceCents[slot->second.index]);
+    }
+}
+
+/**
+* @brief Applies the withdrawals that belong to one lane
+*
+* withdrawLane():
+* A function that checks every withdrawal of the lane against its policy and the running balance, in the order they were requested.
+* The policy's type is known here, so the check is a plain inlined comparison. The accepted withdrawals are then posted together,
+* and if the journal refuses an entry because another change got there first, its withdrawals are posted one by one like 'withdraw' would.
+*
+* @param lane The lane that the withdrawals belong to
+* @param work Pairs of (request index, lane index), in request order
+* @param requests Every withdrawal given to the batch
+* @param results Set to true for each withdrawal that succeeded
+*/
+template <typename Policy>
+void AccountBatch::withdrawLane(Lane<Policy>& lane, const vector<pair<size_t, size_t>>& work, const vector<WithdrawalRequest>& requests, vector<bool>& results) {
+    Journal& journal = Journal::instance();
+    AccountEvents& events = AccountEvents::instance();
+
+    // Start from the journal's balances, which other changes may have moved since the last batch
+    for (const auto& item : work) {
+        lane.balanceCents[item.second] = Journal::toCents(journal.balance(lane.accountIDs[item.second]));
+    }
+
+    vector<pair<size_t, size_t>> accepted;
+    accepted.reserve(work.size());
+    for (const auto& item : work) {
+        const double amount = requests[item.first].amount;
+        if (lane.policies[item.second].allowsWithdrawal(amount, Journal::fromCents(lane.balanceCents[item.second]))) {
+            lane.balanceCents[item.second] -= Journal::toCents(amount);
+            accepted.push_back(item);
+        }
+    }
+
+    for (size_t begin = 0; begin < accepted.size(); begin += kLegsPerEntry) {
+        const size_t end = min(accepted.size(), begin + kLegsPerEntry);
+
+        // One leg for each withdrawal and one crediting the external account with their total
+        Journal::Entry entry;
+        entry.legs.reserve(end - begin + 1);
+        int64_t total = 0;
+        for (size_t i = begin; i < end; i++) {
+            const int64_t cents = Journal::toCents(requests[accepted[i].first].amount);
+            entry.legs.push_back({ lane.accountIDs[accepted[i].second], -cents });
+            total += cents;
+        }
+        entry.legs.push_back({ Journal::kExternalAccount, total });
+
+        if (journal.post(move(entry)) != 0) {
+            for (size_t i = begin; i < end; i++) {
+                results[accepted[i].first] = true;
+                events.withdrawn(lane.accountIDs[accepted[i].second], requests[accepted[i].first].amount);
+            }
+            continue;
+        }
+
+        // Another change moved one of these balances first, so check each withdrawal again on its own
+        for (size_t i = begin; i < end; i++) {
+            const int accountID = lane.accountIDs[accepted[i].second];
+            const double amount = requests[accepted[i].first].amount;
+            if (lane.policies[accepted[i].second].allowsWithdrawal(amount, journal.balance(accountID)) && journal.post(Journal::withdrawal(accountID, amount)) != 0) {
+                results[accepted[i].first] = true;
+                events.withdrawn(accountID, amount);
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            lane.balanceCents[accepted[i].second] = Journal::toCents(journal.balance(lane.accountIDs[accepted[i].second]));
+        }
+    }
+}
+
+/**
+* @brief Applies many withdrawals to the accounts in the batch
+*
+* withdraw():
+* A function that sorts the withdrawals by the kind of account they are for and then applies each kind's withdrawals in one loop.
+* Each withdrawal follows the same rules as calling 'withdraw' on the account: it must be for more than zero, within the account's balance, and within a Checkings Account's withdrawal limit.
+* Withdrawals for accounts that are not in the batch fail.
+*
+* @param requests The withdrawals to be applied, in the order they were made
+* @return One entry per withdrawal that is true if it succeeded
+*/
+vector<bool> AccountBatch::withdraw(const vector<WithdrawalRequest>& requests) {
+    vector<bool> results(requests.size(), false);
+    vector<pair<size_t, size_t>> standardWork, checkingsWork, savingsWork;
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        const auto slot = slots.find(requests[i].accountID);
+        if (slot == slots.end() || Journal::toCents(requests[i].amount) <= 0) {
+            continue;
+        }
+        switch (slot->second.kind) {
+        case Kind::Checkings:
+            checkingsWork.emplace_back(i, slot->second.index);
+            break;
+        case Kind::Savings:
+            savingsWork.emplace_back(i, slot->second.index);
+            break;
+        default:
+            standardWork.emplace_back(i, slot->second.index);
+            break;
+        }
+    }
+
+    withdrawLane(standard, standardWork, requests, results);
+    withdrawLane(checkings, checkingsWork, requests, results);
+    withdrawLane(savings, savingsWork, requests, results);
+    return results;
+}
+
+/**
+* @brief Applies interest to every Savings Account in the batch
+*
+* applyInterest():
+* A function that works out every Savings Account's interest from its journal balance, the same way 'SavingsAccount::applyInterest' does.
+* The interest is posted to the journal as deposits that share entries, and each payment is recorded in its account's event stream as a Deposited event.
+*/
+void AccountBatch::applyInterest() {
+    Journal& journal = Journal::instance();
+    AccountEvents& events = AccountEvents::instance();
+    const double rate = SavingsAccount::getInterestRate();
+
+    vector<double> interest(savings.accountIDs.size());
+    for (size_t i = 0; i < savings.accountIDs.size(); i++) {
+        interest[i] = SavingsPolicy::interest(journal.balance(savings.accountIDs[i]), rate);
+    }
+
+    for (size_t begin = 0; begin < interest.size(); begin += kLegsPerEntry) {
+        const size_t end = min(interest.size(), begin + kLegsPerEntry);
+
+        // One leg for each payment and one debiting the external account with their total
+        Journal::Entry entry;
+        int64_t total = 0;
+        for (size_t i = begin; i < end; i++) {
+            const int64_t cents = Journal::toCents(interest[i]);
+            if (cents > 0) {
+                entry.legs.push_back({ savings.accountIDs[i], cents });
+                total += cents;
+            }
+        }
+        if (entry.legs.empty()) {
+            continue;
+        }
+        entry.legs.push_back({ Journal::kExternalAccount, -total });
+        journal.post(move(entry));
+
+        for (size_t i = begin; i < end; i++) {
+            if (Journal::toCents(interest[i]) > 0) {
+                events.deposited(savings.accountIDs[i], interest[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < savings.accountIDs.size(); i++) {
+        savings.balanceCents[i] = Journal::toCents(journal.balance(savings.accountIDs[i]));
+    }
+}
+
+/**
+* @brief Turns the batch back into account objects
+*
+* toAccounts():
+* A function that builds an account object of the right kind for every account in the batch, with its balance as of the last batch operation.
+*
+* @return The accounts, one lane after another
+*/
+vector<AnyAccount> AccountBatch::toAccounts() const {
+    vector<AnyAccount> accounts;
+    accounts.reserve(size());
+    for (size_t i = 0; i < standard.accountIDs.size(); i++) {
+        accounts.emplace_back(in_place_type<Account>, standard.accountIDs[i], Journal::fromCents(standard.balanceCents[i]), standard.userIDs[i], standard.accountTypes[i]);
+    }
+    for (size_t i = 0; i < checkings.accountIDs.size(); i++) {
+        accounts.emplace_back(in_place_type<CheckingsAccount>, checkings.accountIDs[i], Journal::fromCents(checkings.balanceCents[i]), checkings.userIDs[i], checkings.accountTypes[i],
+                              checkings.policies[i].withdrawalLimit);
+    }
+    for (size_t i = 0; i < savings.accountIDs.size(); i++) {
+        accounts.emplace_back(in_place_type<SavingsAccount>, savings.accountIDs[i], Journal::fromCents(savings.balanceCents[i]), savings.userIDs[i], savings.accountTypes[i],
+                              SavingsAccount::getInterestRate());
+    }
+    return accounts;
+}
@@ -0,0 +1,96 @@
+#include "AccountChangeLog.h"
+#include "JsonWriter.h"
+
+#include <algorithm>
+#include <vector>
+
+AccountChangeLog& AccountChangeLog::instance() {
+    static AccountChangeLog log;
+    return log;
+}
+
+void AccountChangeLog::recordTransaction(const Transaction& transaction) {
+    append(transaction.getAccountID(), Change{ 0, Kind::Transaction, 0.0, std::make_shared<const std::string>(transaction.toJson()) });
+}
+
+void AccountChangeLog::recordBalance(int accountID, double balance) {
+    append(accountID, Change{ 0, Kind::Balance, balance, nullptr });
+}
+
+/**
+ * @brief Collects the changes after the cursor under the account's lock, then writes the JSON without it.
+ * An account with no log is not given one, so reads do not grow the index.
+ */
+std::string AccountChangeLog::delta(int accountID, const uint64_t* since) {
+    uint64_t cursor = 0;
+    bool reset = false;
+    bool more = false;
+    bool balanceChanged = false;
+    double balance = 0.0;
+    std::vector<std::shared_ptr<const std::string>> added;
+    if (Log* found = logs.find(accountID)) {
+        Log& log = *found;
+        std::lock_guard<std::mutex> lock(log.mutex);
+        const uint64_t oldest = log.changes.empty() ? log.head + 1 : log.changes.front().sequence;
+        if (!since || *since > log.head || *since + 1 < oldest) {
+            reset = true;
+            cursor = log.head;
+        } else {
+            cursor = *since;
+            std::size_t i = static_cast<std::size_t>(cursor + 1 - oldest);
+            const std::size_t end = std::min(log.changes.size(), i + kMaxChangesPerDelta);
+            more = end < log.changes.size();
+            for (; i < end; i++) {
+                const Change& change = log.changes[i];
+                switch (change.kind) {
+                case Kind::Transaction:
+                    added.push_back(change.json);
+                    break;
+                case Kind::Balance:
+                    balanceChanged = true;
+                    balance = change.balance;
+                    break;
+                }
+                cursor = change.sequence;
+            }
+        }
+    } else {
+        // no changes recorded yet, which is an empty log at sequence 0
+        reset = !since || *since != 0;
+    }
+
+    std::string out;
+    out.reserve(64 + added.size() * 128);
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.key("cursor");
+    writer.value(static_cast<int64_t>(cursor));
+    writer.key("reset");
+    writer.value(reset);
+    writer.key("more");
+    writer.value(more);
+    writer.key("balance");
+    if (balanceChanged) {
+        writer.value(balance);
+    } else {
+        writer.null();
+    }
+    writer.key("transactions");
+    writer.beginArray();
+    for (const auto& transaction : added) {
+        writer.raw(*transaction);
+    }
+    writer.endArray();
+    writer.endObject();
+    return out;
+}
+
+void AccountChangeLog::append(int accountID, Change change) {
+    Log& log = logs.get(accountID);
+    std::lock_guard<std::mutex> lock(log.mutex);
+    change.sequence = ++log.head;
+    log.changes.push_back(std::move(change));
+    if (log.changes.size() > kMaxChanges) {
+        log.changes.pop_front();
+    }
+}
@@ -0,0 +1,481 @@
+#include "AccountEvents.h"
+#include "AsyncLogger.h"
+#include "Journal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    static_assert(sizeof(AccountEvents::Event) == 32, "log records are fixed-size");
+    static_assert(sizeof(AccountEvents::State) == 40, "snapshot records are fixed-size");
+
+    const char kSnapshotMagic[8] = { 'A', 'C', 'C', 'E', 'V', 'T', '1', '\0' };
+
+    // Records read or written per call.
+    constexpr std::size_t kBatch = 4096;
+
+    struct SnapshotHeader {
+        char magic[8];
+        uint64_t sequence; // every event up to here is included
+        uint64_t shards;
+    };
+
+    struct FileCloser {
+        void operator()(std::FILE* file) const { std::fclose(file); }
+    };
+    using File = std::unique_ptr<std::FILE, FileCloser>;
+
+    File openFile(const std::filesystem::path& path, const char* mode) {
+        return File(std::fopen(path.string().c_str(), mode));
+    }
+
+    // The log outgrows a 32-bit long.
+    bool seek(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+AccountEvents& AccountEvents::instance() {
+    static AccountEvents events;
+    return events;
+}
+
+AccountEvents::AccountEvents() = default;
+
+AccountEvents::~AccountEvents() {
+    stop();
+    if (log) {
+        std::fclose(log);
+    }
+}
+
+AccountEvents::Kind AccountEvents::kindOf(const std::string& accountType) {
+    if (accountType == "Savings") {
+        return Kind::Savings;
+    }
+    if (accountType == "Checkings") {
+        return Kind::Checkings;
+    }
+    return Kind::Unspecified;
+}
+
+std::string AccountEvents::accountType(Kind kind) {
+    switch (kind) {
+    case Kind::Savings:
+        return "Savings";
+    case Kind::Checkings:
+        return "Checkings";
+    default:
+        return "";
+    }
+}
+
+void AccountEvents::open(int accountID, int userID, Kind kind, double balance) {
+    Shard& shard = accounts.shardFor(accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.entries.count(accountID)) {
+        return;
+    }
+    Event event{ 0, accountID, userID, Journal::toCents(balance), Type::Opened, kind, {} };
+    write(event);
+    shard.entries.emplace(accountID, State{ accountID, userID, event.cents, 0, event.sequence, kind, {} });
+}
+
+uint64_t AccountEvents::deposited(int accountID, double amount) {
+    return append(Event{ 0, accountID, 0, Journal::toCents(amount), Type::Deposited, Kind::Unspecified, {} });
+}
+
+uint64_t AccountEvents::withdrawn(int accountID, double amount) {
+    return append(Event{ 0, accountID, 0, Journal::toCents(amount), Type::Withdrawn, Kind::Unspecified, {} });
+}
+
+uint64_t AccountEvents::limitChanged(int accountID, double limit) {
+    return append(Event{ 0, accountID, 0, Journal::toCents(limit), Type::LimitChanged, Kind::Unspecified, {} });
+}
+
+/**
+ * @brief Both accounts' shards are held while the event is written and applied, so no other event
+ * on either account can come between its sequence and its effect.
+ */
+uint64_t AccountEvents::transferred(int fromAccountID, int toAccountID, double amount) {
+    Event event{ 0, fromAccountID, toAccountID, Journal::toCents(amount), Type::Transferred, Kind::Unspecified, {} };
+    Shard& from = accounts.shardFor(fromAccountID);
+    Shard& to = accounts.shardFor(toAccountID);
+
+    std::unique_lock<std::mutex> first(from.mutex, std::defer_lock);
+    std::unique_lock<std::mutex> second(to.mutex, std::defer_lock);
+    if (&from == &to) {
+        first.lock();
+    } else {
+        std::lock(first, second);
+    }
+
+    auto sender = from.entries.find(fromAccountID);
+    auto recipient = to.entries.find(toAccountID);
+    if (sender == from.entries.end() || recipient == to.entries.end()) {
+        return 0;
+    }
+    write(event);
+    apply(sender->second, event);
+    if (fromAccountID != toAccountID) {
+        apply(recipient->second, event);
+    }
+    return event.sequence;
+}
+
+bool AccountEvents::find(int accountID, State& state) {
+    Shard& shard = accounts.shardFor(accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(accountID);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    state = it->second;
+    return true;
+}
+
+std::vector<AccountEvents::State> AccountEvents::states() {
+    std::vector<State> copy;
+    for (auto& shard : accounts) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& account : shard.entries) {
+            copy.push_back(account.second);
+        }
+    }
+    return copy;
+}
+
+uint64_t AccountEvents::append(Event event) {
+    Shard& shard = accounts.shardFor(event.accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(event.accountID);
+    if (it == shard.entries.end()) {
+        return 0;
+    }
+    write(event);
+    apply(it->second, event);
+    return event.sequence;
+}
+
+/**
+ * @brief Gives the event its sequence and writes it to the log before it is applied anywhere, so
+ * a snapshot never includes an event the log does not have.
+ */
+uint64_t AccountEvents::write(Event& event) {
+    bool due = false;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        event.sequence = ++lastSequence;
+        if (log) {
+            std::fwrite(&event, sizeof(Event), 1, log);
+            std::fflush(log);
+            if (!snapshotRequested && lastSequence - snapshotSequence >= kSnapshotEvery) {
+                snapshotRequested = true;
+                due = true;
+            }
+        }
+    }
+    if (due) {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            snapshotDue = true;
+        }
+        wake.notify_one();
+    }
+    return event.sequence;
+}
+
+void AccountEvents::apply(State& state, const Event& event) {
+    switch (event.type) {
+    case Type::Deposited:
+        state.balanceCents += event.cents;
+        break;
+    case Type::Withdrawn:
+        state.balanceCents -= event.cents;
+        break;
+    case Type::Transferred:
+        if (state.accountID == event.accountID) {
+            state.balanceCents -= event.cents;
+        }
+        if (state.accountID == event.otherID) {
+            state.balanceCents += event.cents;
+        }
+        break;
+    case Type::LimitChanged:
+        state.limitCents = event.cents;
+        break;
+    case Type::Opened:
+        break;
+    }
+    state.version = event.sequence;
+}
+
+/**
+ * @brief Applies a logged event to the accounts that do not include it yet.
+ */
+void AccountEvents::replay(const Event& event) {
+    if (event.type == Type::Opened) {
+        Shard& shard = accounts.shardFor(event.accountID);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.emplace(event.accountID, State{ event.accountID, event.otherID, event.cents, 0, event.sequence, event.kind, {} });
+        return;
+    }
+
+    auto applyTo = [this, &event](int accountID) {
+        Shard& shard = accounts.shardFor(accountID);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(accountID);
+        if (it != shard.entries.end() && it->second.version < event.sequence) {
+            apply(it->second, event);
+        }
+    };
+    applyTo(event.accountID);
+    if (event.type == Type::Transferred && event.otherID != event.accountID) {
+        applyTo(event.otherID);
+    }
+}
+
+/**
+ * @brief Reads the snapshot's shards in parallel, then replays the log from the snapshot's
+ * sequence. Log record n has sequence n + 1, so the tail is found with one seek; a log that
+ * does not line up is scanned from the start instead. A record cut short by a crash is dropped.
+ */
+AccountEvents::LoadStats AccountEvents::load(const std::string& directoryPath, std::size_t threads) {
+    const auto started = std::chrono::steady_clock::now();
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::create_directories(directoryPath, error);
+    if (error) {
+        throw std::runtime_error("cannot create " + directoryPath + ": " + error.message());
+    }
+    const fs::path snapshotPath = fs::path(directoryPath) / "snapshot.bin";
+    const fs::path logPath = fs::path(directoryPath) / "events.log";
+
+    LoadStats stats;
+    if (fs::exists(snapshotPath)) {
+        File in = openFile(snapshotPath, "rb");
+        SnapshotHeader header;
+        if (!in || std::fread(&header, sizeof(header), 1, in.get()) != 1 ||
+            std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header.shards != Accounts::kShards) {
+            throw std::runtime_error("unreadable snapshot " + snapshotPath.string());
+        }
+
+        // where each shard's section starts
+        std::vector<uint64_t> offsets(Accounts::kShards);
+        uint64_t offset = sizeof(header);
+        for (std::size_t s = 0; s < Accounts::kShards; s++) {
+            uint64_t count = 0;
+            if (!seek(in.get(), offset) || std::fread(&count, sizeof(count), 1, in.get()) != 1) {
+                throw std::runtime_error("truncated snapshot " + snapshotPath.string());
+            }
+            offsets[s] = offset;
+            offset += sizeof(count) + count * sizeof(State);
+        }
+
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, Accounts::kShards);
+        std::vector<std::thread> readers;
+        std::vector<int> failed(threads, 0);
+        auto read = [&](std::size_t reader) {
+            File file = openFile(snapshotPath, "rb");
+            std::vector<State> batch(kBatch);
+            for (std::size_t s = reader; s < Accounts::kShards && file; s += threads) {
+                uint64_t count = 0;
+                if (!seek(file.get(), offsets[s]) || std::fread(&count, sizeof(count), 1, file.get()) != 1) {
+                    break;
+                }
+                Shard& shard = accounts.shard(s);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.entries.reserve(shard.entries.size() + count);
+                while (count > 0) {
+                    const std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(count, kBatch));
+                    if (std::fread(batch.data(), sizeof(State), want, file.get()) != want) {
+                        failed[reader] = 1;
+                        return;
+                    }
+                    for (std::size_t i = 0; i < want; i++) {
+                        shard.entries.emplace(batch[i].accountID, batch[i]);
+                    }
+                    count -= want;
+                }
+            }
+            failed[reader] = file ? 0 : 1;
+        };
+        for (std::size_t reader = 1; reader < threads; reader++) {
+            readers.emplace_back(read, reader);
+        }
+        read(0);
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        if (std::count(failed.begin(), failed.end(), 1) != 0) {
+            throw std::runtime_error("truncated snapshot " + snapshotPath.string());
+        }
+        stats.snapshotSequence = header.sequence;
+    }
+
+    uint64_t last = stats.snapshotSequence;
+    if (fs::exists(logPath)) {
+        const uint64_t records = fs::file_size(logPath) / sizeof(Event);
+        if (fs::file_size(logPath) != records * sizeof(Event)) {
+            fs::resize_file(logPath, records * sizeof(Event));
+        }
+
+        File in = openFile(logPath, "rb");
+        if (!in) {
+            throw std::runtime_error("cannot read " + logPath.string());
+        }
+        std::vector<Event> batch(kBatch);
+        uint64_t index = std::min(stats.snapshotSequence, records);
+        Event first;
+        if (index > 0 && (!seek(in.get(), (index - 1) * sizeof(Event)) ||
+                          std::fread(&first, sizeof(Event), 1, in.get()) != 1 || first.sequence != index)) {
+            index = 0;
+        }
+        seek(in.get(), index * sizeof(Event));
+
+        std::size_t got;
+        while ((got = std::fread(batch.data(), sizeof(Event), kBatch, in.get())) > 0) {
+            for (std::size_t i = 0; i < got; i++) {
+                const Event& event = batch[i];
+                if (event.sequence > stats.snapshotSequence) {
+                    replay(event);
+                    stats.replayed++;
+                }
+                last = std::max(last, event.sequence);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        log = std::fopen(logPath.string().c_str(), "ab");
+        if (!log) {
+            throw std::runtime_error("cannot append to " + logPath.string());
+        }
+        directory = directoryPath;
+        lastSequence = last;
+        snapshotSequence = stats.snapshotSequence;
+    }
+    if (!snapshotter.joinable()) {
+        snapshotter = std::thread([this] { run(); });
+    }
+
+    for (auto& shard : accounts) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.accounts += shard.entries.size();
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    AsyncLogger::instance().log(AsyncLogger::Level::Info, "account_events.loaded", { { "accounts", static_cast<long long>(stats.accounts) }, { "snapshot", static_cast<long long>(stats.snapshotSequence) }, { "replayed", static_cast<long long>(stats.replayed) }, { "seconds", stats.seconds } });
+    return stats;
+}
+
+/**
+ * @brief Copies one shard at a time, so appends to the other shards carry on. The file is written
+ * beside the current snapshot and renamed over it once complete.
+ */
+uint64_t AccountEvents::snapshot() {
+    std::lock_guard<std::mutex> snapshotLock(snapshotMutex);
+    const auto started = std::chrono::steady_clock::now();
+    uint64_t covered;
+    std::string target;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        if (!log) {
+            return 0;
+        }
+        covered = lastSequence;
+        target = directory;
+    }
+
+    const std::filesystem::path temporary = std::filesystem::path(target) / "snapshot.tmp";
+    File out = openFile(temporary, "wb");
+    if (!out) {
+        throw std::runtime_error("cannot write " + temporary.string());
+    }
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.sequence = covered;
+    header.shards = Accounts::kShards;
+    bool written = std::fwrite(&header, sizeof(header), 1, out.get()) == 1;
+
+    std::size_t copied = 0;
+    std::vector<State> copy;
+    for (auto& shard : accounts) {
+        copy.clear();
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            copy.reserve(shard.entries.size());
+            for (const auto& account : shard.entries) {
+                copy.push_back(account.second);
+            }
+        }
+        const uint64_t count = copy.size();
+        written = written && std::fwrite(&count, sizeof(count), 1, out.get()) == 1 &&
+                  std::fwrite(copy.data(), sizeof(State), copy.size(), out.get()) == copy.size();
+        copied += copy.size();
+    }
+    written = std::fflush(out.get()) == 0 && written;
+    out.reset();
+    if (!written) {
+        throw std::runtime_error("cannot write " + temporary.string());
+    }
+    std::filesystem::rename(temporary, std::filesystem::path(target) / "snapshot.bin");
+
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        snapshotSequence = covered;
+        snapshotRequested = false;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    AsyncLogger::instance().log(AsyncLogger::Level::Info, "account_events.snapshot", { { "sequence", static_cast<long long>(covered) }, { "accounts", static_cast<long long>(copied) }, { "seconds", seconds } });
+    return covered;
+}
+
+void AccountEvents::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (snapshotter.joinable()) {
+        snapshotter.join();
+    }
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (log) {
+        std::fflush(log);
+    }
+}
+
+
+void AccountEvents::run() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || snapshotDue; });
+        if (stopping) {
+            return;
+        }
+        snapshotDue = false;
+        lock.unlock();
+        try {
+            snapshot();
+        } catch (const std::exception& e) {
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "account_events.snapshot_failed", { { "error", std::string(e.what()) } });
+            std::lock_guard<std::mutex> logLock(logMutex);
+            snapshotRequested = false; // try again after the next kSnapshotEvery events
+            snapshotSequence = lastSequence;
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,160 @@
+#include "AdmissionControl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr uint64_t kInitialLimit = 64;
+    constexpr uint64_t kMinLimit = 8;
+    constexpr uint64_t kMaxLimit = 1024;
+
+    // Fraction of the concurrency limit each class may use, in percent.
+    constexpr uint64_t kSharePercent[AdmissionControl::kClasses] = { 100, 75, 50 };
+
+    uint64_t micros(std::chrono::steady_clock::duration d) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    }
+}
+
+AdmissionControl::AdmissionControl()
+    : limit(kInitialLimit),
+      intervalEnd(0),
+      epoch(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief Classifies the request and admits it, or answers 503 if its class is being shed.
+ */
+void AdmissionControl::before_handle(crow::request& req, crow::response& res, context& ctx) {
+    const auto now = std::chrono::steady_clock::now();
+    maybeAdvance(now);
+
+    ctx.routeClass = classify(req);
+    ClassState& state = classes[static_cast<std::size_t>(ctx.routeClass)];
+    const uint64_t inFlight = totalInFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!allowed(ctx.routeClass, inFlight)) {
+        totalInFlight.fetch_sub(1, std::memory_order_relaxed);
+        state.shed.fetch_add(1, std::memory_order_relaxed);
+        res.code = 503;
+        res.set_header("Retry-After", "1");
+        res.end("Server busy.");
+        return;
+    }
+
+    ctx.admitted = true;
+    ctx.start = now;
+    state.inFlight.fetch_add(1, std::memory_order_relaxed);
+    state.admitted.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Releases the request's slot and records its latency; for async handlers this runs at res.end().
+ */
+void AdmissionControl::after_handle(crow::request& /*req*/, crow::response& /*res*/, context& ctx) {
+    if (!ctx.admitted) {
+        return;
+    }
+    ctx.admitted = false;
+    totalInFlight.fetch_sub(1, std::memory_order_relaxed);
+    classes[static_cast<std::size_t>(ctx.routeClass)].inFlight.fetch_sub(1, std::memory_order_relaxed);
+    recordLatency(ctx.routeClass, micros(std::chrono::steady_clock::now() - ctx.start));
+}
+
+void AdmissionControl::watch(PriorityScheduler& watched) {
+    scheduler = &watched;
+}
+
+void AdmissionControl::setTarget(std::chrono::milliseconds newTarget, std::chrono::milliseconds newInterval) {
+    target = newTarget;
+    interval = newInterval;
+}
+
+AdmissionControl::Stats AdmissionControl::stats() const {
+    Stats result{};
+    for (std::size_t i = 0; i < kClasses; i++) {
+        result.classes[i] = ClassStats{
+            classes[i].inFlight.load(std::memory_order_relaxed),
+            classes[i].admitted.load(std::memory_order_relaxed),
+            classes[i].shed.load(std::memory_order_relaxed),
+            classes[i].latencyMicros.load(std::memory_order_relaxed),
+        };
+    }
+    result.queueDelayMicros = lastMinDelay.load(std::memory_order_relaxed);
+    result.overloadLevel = overloadLevel.load(std::memory_order_relaxed);
+    result.concurrencyLimit = limit.load(std::memory_order_relaxed);
+    return result;
+}
+
+/**
+ * @brief Puts a request in the route class of its scheduler priority: transfers are critical,
+ * account reads are reads, history and static files are bulk.
+ */
+AdmissionControl::RouteClass AdmissionControl::classify(const crow::request& req) {
+    switch (PriorityScheduler::routePriority(req)) {
+    case PriorityScheduler::Priority::Transfer:
+        return RouteClass::Critical;
+    case PriorityScheduler::Priority::AccountRead:
+        return RouteClass::Read;
+    default:
+        return RouteClass::Bulk;
+    }
+}
+
+void AdmissionControl::recordLatency(RouteClass routeClass, uint64_t latency) {
+    auto& smoothed = classes[static_cast<std::size_t>(routeClass)].latencyMicros;
+    const uint64_t previous = smoothed.load(std::memory_order_relaxed);
+    smoothed.store(previous == 0 ? latency : (previous * 7 + latency) / 8, std::memory_order_relaxed);
+    intervalLatencySum.fetch_add(latency, std::memory_order_relaxed);
+    intervalLatencyCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief At the end of each interval, moves the overload level (CoDel) and the concurrency limit (gradient).
+ */
+void AdmissionControl::maybeAdvance(std::chrono::steady_clock::time_point now) {
+    const int64_t nowMicros = static_cast<int64_t>(micros(now - epoch));
+    if (nowMicros < intervalEnd.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(advanceMutex, std::try_to_lock);
+    if (!lock || nowMicros < intervalEnd.load(std::memory_order_relaxed)) {
+        return;
+    }
+    intervalEnd.store(nowMicros + interval.count(), std::memory_order_relaxed);
+
+    const uint64_t minDelay = scheduler ? scheduler->takeQueueDelay() : 0;
+    lastMinDelay.store(minDelay, std::memory_order_relaxed);
+    int level = overloadLevel.load(std::memory_order_relaxed);
+    if (minDelay > static_cast<uint64_t>(target.count())) {
+        level = std::min(level + 1, 2);
+    } else {
+        level = std::max(level - 1, 0);
+    }
+    overloadLevel.store(level, std::memory_order_relaxed);
+
+    const uint64_t count = intervalLatencyCount.exchange(0, std::memory_order_relaxed);
+    const uint64_t sum = intervalLatencySum.exchange(0, std::memory_order_relaxed);
+    if (count == 0) {
+        return;
+    }
+    const uint64_t average = std::max<uint64_t>(sum / count, 1);
+    // let the best latency drift up slowly so a stale minimum cannot pin the limit down
+    bestLatency = bestLatency == 0 ? average : std::min(average, bestLatency + bestLatency / 64 + 1);
+
+    const double current = static_cast<double>(limit.load(std::memory_order_relaxed));
+    const double gradient = std::clamp(static_cast<double>(bestLatency) / static_cast<double>(average), 0.5, 1.0);
+    const double proposed = current * gradient + std::sqrt(current);
+    const double smoothed = current * 0.8 + proposed * 0.2;
+    limit.store(std::clamp<uint64_t>(static_cast<uint64_t>(smoothed), kMinLimit, kMaxLimit), std::memory_order_relaxed);
+}
+
+bool AdmissionControl::allowed(RouteClass routeClass, uint64_t inFlight) const {
+    const int level = overloadLevel.load(std::memory_order_relaxed);
+    if (routeClass == RouteClass::Bulk && level >= 1) {
+        return false;
+    }
+    if (routeClass == RouteClass::Read && level >= 2) {
+        return false;
+    }
+    const uint64_t share = limit.load(std::memory_order_relaxed) * kSharePercent[static_cast<std::size_t>(routeClass)] / 100;
+    return inFlight <= std::max<uint64_t>(share, 1);
+}
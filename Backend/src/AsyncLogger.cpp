@@ -0,0 +1,294 @@
+#include "AsyncLogger.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+constexpr const char* kLevelTags[] = { "DEBUG   ", "INFO    ", "WARNING ", "ERROR   ", "CRITICAL" };
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Keeps a thread's ring registered until the thread exits, then marks it for removal.
+struct RingOwner {
+    std::shared_ptr<void> ring;
+    std::atomic<bool>* orphaned = nullptr;
+    ~RingOwner() {
+        if (orphaned) {
+            orphaned->store(true, std::memory_order_release);
+        }
+    }
+};
+
+} // namespace
+
+AsyncLogger::Field::Field(const char* key, long long number) : key(key), type(Type::Int) {
+    value.i = number;
+}
+
+AsyncLogger::Field::Field(const char* key, double number) : key(key), type(Type::Double) {
+    value.d = number;
+}
+
+AsyncLogger::Field::Field(const char* key, std::string_view text) : key(key), type(Type::String) {
+    length = static_cast<uint8_t>(std::min(text.size(), kMaxStringBytes));
+    truncated = text.size() > kMaxStringBytes;
+    std::memcpy(value.s, text.data(), length);
+}
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::AsyncLogger() {
+    out.reserve(64 * 1024);
+    flusher = std::thread([this] { run(); });
+}
+
+AsyncLogger::~AsyncLogger() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    flush();
+}
+
+/**
+ * @brief Returns the calling thread's ring, registering it on the thread's first record.
+ */
+AsyncLogger::Ring& AsyncLogger::threadRing() {
+    thread_local Ring* ring = nullptr;
+    thread_local RingOwner owner;
+    if (!ring) {
+        auto created = std::make_shared<Ring>();
+        ring = created.get();
+        owner.ring = created;
+        owner.orphaned = &created->orphaned;
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.push_back(std::move(created));
+    }
+    return *ring;
+}
+
+/**
+ * @brief Reserves the next slot of the calling thread's ring.
+ * @return The slot, or nullptr if the ring is full (the record is counted as dropped).
+ */
+AsyncLogger::Record* AsyncLogger::beginRecord(Ring*& ring) {
+    ring = &threadRing();
+    const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) >= kRingCapacity) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &ring->records[tail & (kRingCapacity - 1)];
+}
+
+void AsyncLogger::commitRecord(Ring* ring) {
+    ring->tail.store(ring->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AsyncLogger::log(Level level, const char* event, std::initializer_list<Field> fields) {
+    Ring* ring;
+    Record* record = beginRecord(ring);
+    if (!record) {
+        return;
+    }
+    record->timeNs = nowNs();
+    record->event = event;
+    record->level = level;
+    record->textLength = 0;
+    record->fieldCount = static_cast<uint8_t>(std::min(fields.size(), kMaxFields));
+    std::copy_n(fields.begin(), record->fieldCount, record->fields);
+    commitRecord(ring);
+}
+
+void AsyncLogger::logText(Level level, std::string_view text) {
+    Ring* ring;
+    Record* record = beginRecord(ring);
+    if (!record) {
+        return;
+    }
+    const size_t length = std::min(text.size(), sizeof(record->text));
+    record->timeNs = nowNs();
+    record->event = nullptr;
+    record->level = level;
+    record->fieldCount = 0;
+    record->textLength = static_cast<uint16_t>(length);
+    std::memcpy(record->text, text.data(), length);
+    commitRecord(ring);
+}
+
+void AsyncLogger::flush() {
+    std::lock_guard<std::mutex> lock(drainMutex);
+    drain();
+}
+
+uint64_t AsyncLogger::dropped() const {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    uint64_t total = retiredDrops;
+    for (const auto& ring : rings) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void AsyncLogger::setOutput(FILE* stream) {
+    std::lock_guard<std::mutex> lock(drainMutex);
+    drain();
+    output = stream;
+}
+
+/**
+ * @brief Flusher loop: drains all rings, then sleeps briefly when there was nothing to write.
+ */
+void AsyncLogger::run() {
+    std::unique_lock<std::mutex> wakeLock(wakeMutex);
+    while (!stopping) {
+        wakeLock.unlock();
+        bool wrote;
+        {
+            std::lock_guard<std::mutex> lock(drainMutex);
+            wrote = drain();
+        }
+        wakeLock.lock();
+        if (!wrote) {
+            wake.wait_for(wakeLock, std::chrono::milliseconds(20));
+        }
+    }
+}
+
+/**
+ * @brief Formats and writes every committed record; the caller holds drainMutex.
+ * @return True if anything was written.
+ */
+bool AsyncLogger::drain() {
+    std::vector<std::shared_ptr<Ring>> snapshot;
+    uint64_t drops;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+        drops = retiredDrops;
+    }
+
+    for (const auto& ring : snapshot) {
+        const uint64_t head = ring->head.load(std::memory_order_relaxed);
+        const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i != tail; i++) {
+            format(ring->records[i & (kRingCapacity - 1)]);
+        }
+        ring->head.store(tail, std::memory_order_release);
+        drops += ring->dropped.load(std::memory_order_relaxed);
+    }
+
+    if (drops > reportedDrops) {
+        Record notice;
+        notice.timeNs = nowNs();
+        notice.event = "logger.dropped";
+        notice.level = Level::Warning;
+        notice.textLength = 0;
+        notice.fieldCount = 1;
+        notice.fields[0] = Field("records", static_cast<long long>(drops - reportedDrops));
+        format(notice);
+        reportedDrops = drops;
+    }
+
+    {
+        // forget rings whose thread has exited and whose records are all written
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [this](const std::shared_ptr<Ring>& ring) {
+            bool retired = ring->orphaned.load(std::memory_order_acquire) &&
+                ring->head.load(std::memory_order_relaxed) == ring->tail.load(std::memory_order_acquire);
+            if (retired) {
+                retiredDrops += ring->dropped.load(std::memory_order_relaxed);
+            }
+            return retired;
+        }), rings.end());
+    }
+
+    if (out.empty()) {
+        return false;
+    }
+    std::fwrite(out.data(), 1, out.size(), output);
+    std::fflush(output);
+    out.clear();
+    return true;
+}
+
+/**
+ * @brief Appends one record as text, in the same layout as Crow's own log lines.
+ */
+void AsyncLogger::format(const Record& record) {
+    if (!record.event) {
+        out.append(record.text, record.textLength);
+        if (record.textLength == 0 || record.text[record.textLength - 1] != '\n') {
+            out += '\n';
+        }
+        return;
+    }
+
+    const int64_t second = record.timeNs / 1000000000;
+    if (second != cachedSecond) {
+        cachedSecond = second;
+        time_t t = static_cast<time_t>(second);
+        tm utc;
+#ifdef _MSC_VER
+        gmtime_s(&utc, &t);
+#else
+        gmtime_r(&t, &utc);
+#endif
+        std::strftime(cachedTime, sizeof(cachedTime), "%Y-%m-%d %H:%M:%S", &utc);
+    }
+
+    out += '(';
+    out += cachedTime;
+    out += ") [";
+    out += kLevelTags[static_cast<int>(record.level)];
+    out += "] ";
+    out += record.event;
+
+    char digits[32];
+    for (uint8_t i = 0; i < record.fieldCount; i++) {
+        const Field& field = record.fields[i];
+        out += ' ';
+        out += field.key;
+        out += '=';
+        switch (field.type) {
+            case Field::Type::Int: {
+                auto result = std::to_chars(digits, digits + sizeof(digits), field.value.i);
+                out.append(digits, result.ptr);
+                break;
+            }
+            case Field::Type::Double: {
+                auto result = std::to_chars(digits, digits + sizeof(digits), field.value.d);
+                out.append(digits, result.ptr);
+                break;
+            }
+            case Field::Type::String:
+                out += '"';
+                for (uint8_t c = 0; c < field.length; c++) {
+                    if (field.value.s[c] == '"' || field.value.s[c] == '\\') {
+                        out += '\\';
+                    }
+                    out += field.value.s[c];
+                }
+                if (field.truncated) {
+                    out += "...";
+                }
+                out += '"';
+                break;
+        }
+    }
+    out += '\n';
+}
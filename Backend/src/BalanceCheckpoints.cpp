@@ -0,0 +1,93 @@
+#include "BalanceCheckpoints.h"
+
+#include <algorithm>
+#include <limits>
+
+BalanceCheckpoints& BalanceCheckpoints::instance() {
+    static BalanceCheckpoints checkpoints;
+    return checkpoints;
+}
+
+void BalanceCheckpoints::record(const Transaction& transaction) {
+    Track& track = tracks.get(transaction.getAccountID());
+    std::lock_guard<std::mutex> lock(track.mutex);
+    if (++track.committed % kInterval == 0) {
+        add(track, Checkpoint{ transaction.getTransactionID(), transaction.getBalanceAfter() });
+    }
+}
+
+/**
+ * @brief Replays the rows between the checkpoint and the page without the lock, since reading
+ * them may go to Firestore. A page whose first missing balance follows a stored one needs no replay.
+ */
+void BalanceCheckpoints::fill(int accountID, int afterTransactionID, std::vector<Transaction>& page, const PageReader& reader) {
+    const auto missing = std::find_if(page.begin(), page.end(), [](const Transaction& row) { return !row.hasBalanceAfter(); });
+    if (missing == page.end()) {
+        return;
+    }
+
+    Track& track = tracks.get(accountID);
+    std::vector<Checkpoint> found;
+    double balance;
+    if (missing != page.begin()) {
+        balance = (missing - 1)->getBalanceAfter();
+    } else {
+        Checkpoint start{ std::numeric_limits<int>::min(), 0.0 };
+        {
+            // the newest checkpoint at or below the row the page was read after
+            std::lock_guard<std::mutex> lock(track.mutex);
+            auto it = std::upper_bound(track.checkpoints.begin(), track.checkpoints.end(), afterTransactionID,
+                                       [](int id, const Checkpoint& checkpoint) { return id < checkpoint.transactionID; });
+            if (it != track.checkpoints.begin()) {
+                start = *(it - 1);
+            }
+        }
+
+        balance = start.balance;
+        int cursor = start.transactionID;
+        std::size_t replayed = 0;
+        for (bool done = cursor >= afterTransactionID; !done;) {
+            const std::vector<Transaction> rows = reader(accountID, cursor, kInterval);
+            for (const auto& row : rows) {
+                if (row.getTransactionID() > afterTransactionID) {
+                    done = true;
+                    break;
+                }
+                balance = row.hasBalanceAfter() ? row.getBalanceAfter() : balance + row.getAmount();
+                cursor = row.getTransactionID();
+                if (++replayed % kInterval == 0) {
+                    found.push_back(Checkpoint{ cursor, balance });
+                }
+            }
+            done = done || rows.size() < kInterval;
+        }
+        if (replayed % kInterval != 0) {
+            found.push_back(Checkpoint{ cursor, balance });
+        }
+    }
+
+    for (auto row = missing; row != page.end(); ++row) {
+        if (row->hasBalanceAfter()) {
+            balance = row->getBalanceAfter();
+        } else {
+            balance += row->getAmount();
+            row->setBalanceAfter(balance);
+        }
+    }
+    found.push_back(Checkpoint{ page.back().getTransactionID(), balance });
+
+    std::lock_guard<std::mutex> lock(track.mutex);
+    for (const auto& checkpoint : found) {
+        add(track, checkpoint);
+    }
+}
+
+void BalanceCheckpoints::add(Track& track, const Checkpoint& checkpoint) {
+    auto it = std::lower_bound(track.checkpoints.begin(), track.checkpoints.end(), checkpoint.transactionID,
+                               [](const Checkpoint& existing, int id) { return existing.transactionID < id; });
+    if (it != track.checkpoints.end() && it->transactionID == checkpoint.transactionID) {
+        *it = checkpoint;
+    } else {
+        track.checkpoints.insert(it, checkpoint);
+    }
+}
@@ -0,0 +1,269 @@
+#include "BalanceFeed.h"
+#include "JsonIndex.h"
+#include "JsonWriter.h"
+
+#include "crow_all.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace {
+    // Account IDs come from clients as JSON numbers; casting one outside int's range is undefined.
+    bool validAccountID(double accountID) {
+        return accountID >= std::numeric_limits<int>::min() && accountID <= std::numeric_limits<int>::max() &&
+               std::floor(accountID) == accountID;
+    }
+}
+
+struct BalanceFeed::Subscriber {
+    crow::websocket::connection* conn;
+    boost::asio::io_service* io;               // the connection's thread; outlives the connection
+    std::mutex mutex;
+    std::unordered_map<int, Update> pending;   // latest update per account, guarded by mutex
+    std::vector<int> accounts;                 // only touched on the connection's thread
+    bool scheduled = false;                    // waiting for the next flush, guarded by mutex
+    bool closed = false;                       // guarded by mutex
+};
+
+BalanceFeed& BalanceFeed::instance() {
+    static BalanceFeed feed;
+    return feed;
+}
+
+BalanceFeed::BalanceFeed() : flusher([this] { run(); }) {}
+
+BalanceFeed::~BalanceFeed() {
+    stop();
+}
+
+void BalanceFeed::stop() {
+    {
+        std::lock_guard<std::mutex> lock(dirtyMutex);
+        stopping = true;
+        dirty.clear();
+    }
+    dirtyReady.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+}
+
+/**
+ * @brief Records the change in the pending set of every subscriber of the account.
+ */
+void BalanceFeed::publish(int accountID, double balance) {
+    const uint64_t seq = sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    published.fetch_add(1, std::memory_order_relaxed);
+    for (const auto& listener : listeners) {
+        listener(accountID, balance);
+    }
+    if (subscriptions.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    Topics::Shard& shard = topics.shardFor(accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto topic = shard.entries.find(accountID);
+    if (topic == shard.entries.end()) {
+        return;
+    }
+    for (const auto& subscriber : topic->second) {
+        bool wasScheduled;
+        {
+            std::lock_guard<std::mutex> subscriberLock(subscriber->mutex);
+            if (subscriber->closed) {
+                continue;
+            }
+            auto entry = subscriber->pending.try_emplace(accountID, Update{ balance, seq });
+            if (!entry.second) {
+                entry.first->second = Update{ balance, seq };
+                coalesced.fetch_add(1, std::memory_order_relaxed);
+            }
+            wasScheduled = subscriber->scheduled;
+            subscriber->scheduled = true;
+        }
+        if (!wasScheduled) {
+            schedule(subscriber);
+        }
+    }
+}
+
+void BalanceFeed::listen(std::function<void(int, double)> listener) {
+    listeners.push_back(std::move(listener));
+}
+
+void BalanceFeed::open(crow::websocket::connection& conn) {
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->conn = &conn;
+    subscriber->io = &conn.get_io_service();
+    conn.userdata(new std::shared_ptr<Subscriber>(std::move(subscriber)));
+    connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BalanceFeed::message(crow::websocket::connection& conn, std::string_view text) {
+    auto* holder = static_cast<std::shared_ptr<Subscriber>*>(conn.userdata());
+    if (!holder) {
+        return;
+    }
+    thread_local JsonIndex index;
+    if (!index.parse(text)) {
+        return;
+    }
+    double accountID;
+    if (index.getDouble("subscribe", accountID)) {
+        if (validAccountID(accountID)) {
+            subscribe(*holder, static_cast<int>(accountID));
+        }
+    } else if (index.getDouble("unsubscribe", accountID)) {
+        if (validAccountID(accountID)) {
+            unsubscribe(*holder, static_cast<int>(accountID));
+        }
+    }
+}
+
+void BalanceFeed::close(crow::websocket::connection& conn) {
+    auto* holder = static_cast<std::shared_ptr<Subscriber>*>(conn.userdata());
+    if (!holder) {
+        return;
+    }
+    conn.userdata(nullptr);
+    const std::shared_ptr<Subscriber> subscriber = std::move(*holder);
+    delete holder;
+    {
+        std::lock_guard<std::mutex> lock(subscriber->mutex);
+        subscriber->closed = true;
+        subscriber->pending.clear();
+    }
+    const std::vector<int> accounts = std::move(subscriber->accounts);
+    for (int accountID : accounts) {
+        unsubscribe(subscriber, accountID);
+    }
+    connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void BalanceFeed::setLimits(std::chrono::milliseconds flushInterval, std::size_t queuedBytes) {
+    flushIntervalMs.store(std::max<int64_t>(flushInterval.count(), 1), std::memory_order_relaxed);
+    maxQueuedBytes.store(queuedBytes, std::memory_order_relaxed);
+}
+
+BalanceFeed::Stats BalanceFeed::stats() const {
+    return Stats{
+        connections.load(std::memory_order_relaxed),
+        published.load(std::memory_order_relaxed),
+        delivered.load(std::memory_order_relaxed),
+        coalesced.load(std::memory_order_relaxed),
+        frames.load(std::memory_order_relaxed),
+        deferred.load(std::memory_order_relaxed),
+    };
+}
+
+void BalanceFeed::subscribe(const std::shared_ptr<Subscriber>& subscriber, int accountID) {
+    auto& accounts = subscriber->accounts;
+    if (accounts.size() >= kMaxAccountsPerConnection || std::find(accounts.begin(), accounts.end(), accountID) != accounts.end()) {
+        return;
+    }
+    accounts.push_back(accountID);
+    Topics::Shard& shard = topics.shardFor(accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.entries[accountID].push_back(subscriber);
+    subscriptions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void BalanceFeed::unsubscribe(const std::shared_ptr<Subscriber>& subscriber, int accountID) {
+    auto& accounts = subscriber->accounts;
+    accounts.erase(std::remove(accounts.begin(), accounts.end(), accountID), accounts.end());
+
+    Topics::Shard& shard = topics.shardFor(accountID);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto topic = shard.entries.find(accountID);
+    if (topic == shard.entries.end()) {
+        return;
+    }
+    auto& subscribers = topic->second;
+    auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+    if (it == subscribers.end()) {
+        return;
+    }
+    // order does not matter, so swap with the last one instead of shifting
+    std::swap(*it, subscribers.back());
+    subscribers.pop_back();
+    if (subscribers.empty()) {
+        shard.entries.erase(topic);
+    }
+    subscriptions.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void BalanceFeed::schedule(const std::shared_ptr<Subscriber>& subscriber) {
+    std::lock_guard<std::mutex> lock(dirtyMutex);
+    if (!stopping) {
+        dirty.push_back(subscriber);
+    }
+}
+
+/**
+ * @brief Sends the subscriber's pending updates as one frame; runs on the connection's thread,
+ * where the connection is known to be alive until close() marks the subscriber closed.
+ */
+void BalanceFeed::flush(const std::shared_ptr<Subscriber>& subscriber) {
+    std::string frame;
+    {
+        std::lock_guard<std::mutex> lock(subscriber->mutex);
+        if (subscriber->closed || subscriber->pending.empty()) {
+            subscriber->scheduled = false;
+            return;
+        }
+        if (subscriber->conn->send_queue_bytes() > maxQueuedBytes.load(std::memory_order_relaxed)) {
+            // the client is behind; keep coalescing and try again next interval
+            deferred.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            JsonWriter writer(frame);
+            writer.beginObject();
+            writer.key("type");
+            writer.value("balances");
+            writer.key("updates");
+            writer.beginArray();
+            for (const auto& entry : subscriber->pending) {
+                writer.beginObject();
+                writer.key("accountID");
+                writer.value(entry.first);
+                writer.key("balance");
+                writer.value(entry.second.balance);
+                writer.key("sequence");
+                writer.value(static_cast<int64_t>(entry.second.sequence));
+                writer.endObject();
+            }
+            writer.endArray();
+            writer.endObject();
+            delivered.fetch_add(subscriber->pending.size(), std::memory_order_relaxed);
+            subscriber->pending.clear();
+            subscriber->scheduled = false;
+        }
+    }
+
+    if (frame.empty()) {
+        schedule(subscriber);
+        return;
+    }
+    frames.fetch_add(1, std::memory_order_relaxed);
+    subscriber->conn->send_text(frame);
+}
+
+void BalanceFeed::run() {
+    std::vector<std::shared_ptr<Subscriber>> batch;
+    std::unique_lock<std::mutex> lock(dirtyMutex);
+    while (!stopping) {
+        dirtyReady.wait_for(lock, std::chrono::milliseconds(flushIntervalMs.load(std::memory_order_relaxed)));
+        if (stopping || dirty.empty()) {
+            continue;
+        }
+        batch.swap(dirty);
+        lock.unlock();
+        for (auto& subscriber : batch) {
+            subscriber->io->post([this, subscriber] { flush(subscriber); });
+        }
+        batch.clear();
+        lock.lock();
+    }
+}
@@ -11,6 +11,8 @@
 */
 
 #include "CheckingsAccount.h"
+#include "Journal.h"
+#include "AccountEvents.h"
 
 using namespace std;
 
@@ -34,27 +36,30 @@ CheckingsAccount::CheckingsAccount(int accountID, double balance, int userID, st
 * @brief This function overrides the withdraw function in the 'Account' so that it now limits the amount a user can withdraw from a withdraw request.
 *
 * withdraw():
-* A function that overrides the 'withdraw' function in the 'Account' class.
+* A function that overrides the 'withdraw' function in the 'Account' class, so calls through an 'Account' reference still go through the virtual table. The rule itself lives in 'CheckingsPolicy'.
 * It ensures that the user cannot withdraw more than their withdrawal limit and their account balance from a withdraw request
 *
 * @param amount The amount to be withdrawn 
 */
 void CheckingsAccount::withdraw(double amount) {
+    if (!isValidAmount(amount)) {
+        // Frontend: Display on screen "Please enter an amount greater than zero."
+        return;
+    }
 
-    // If the amount to be withdrawn exceeds the withdrawal limit:
-    if (amount > withdrawalLimit) {
-        
-        // Frontend: Display on screen "Withdrawal amount exceeds limit."
-    } 
+    Journal& journal = Journal::instance();
+    openLedgers();
+    setBalance(journal.balance(getAccountID()));
 
-    // If the amount to be withdrawn exceeds the account's current balance:
-    else if (amount > getBalance()) {
+    // If the amount to be withdrawn exceeds the withdrawal limit or the account's current balance:
+    if (!getPolicy().allowsWithdrawal(amount, getBalance()) || journal.post(Journal::withdrawal(getAccountID(), amount)) == 0) {
         
-        // Frontend: Display on screen "Insufficient Funds. Please enter a lower withdrawal amount."
+        // Frontend: Display on screen "Withdrawal amount exceeds limit." or "Insufficient Funds. Please enter a lower withdrawal amount."
     }
 
     else {
-        setBalance(getBalance() - amount); // Deduct the amount being withdrawn from the account's balance if it is less than or equal to the account's balance and withdrawal limit
+        setBalance(journal.balance(getAccountID())); // The account's balance after the withdrawal was posted
+        AccountEvents::instance().withdrawn(getAccountID(), amount);
     }
 }
 
@@ -75,9 +80,24 @@ double CheckingsAccount::getWithdrawalLimit() const {
 *
 * setWithdrawalLimit():
 * A setter function that replaces the account's current withdrawal limit with a different one
+* The change is appended to the account's event stream as a LimitChanged event
 *
 * @param newLimit The account's new withdrawal limit
 */
 void CheckingsAccount::setWithdrawalLimit(double newLimit) {
     withdrawalLimit = newLimit;
+    openLedgers();
+    AccountEvents::instance().limitChanged(getAccountID(), newLimit);
+}
+
+/**
+* @brief Returns the withdrawal policy of the Checkings Account.
+*
+* getPolicy():
+* A Getter function that returns a 'CheckingsPolicy' built from the account's withdrawal limit. 'withdraw' checks it, and 'AccountBatch' stores it in its Checkings lane.
+*
+* @return The account's withdrawal policy
+*/
+CheckingsPolicy CheckingsAccount::getPolicy() const {
+    return CheckingsPolicy{ withdrawalLimit };
 }
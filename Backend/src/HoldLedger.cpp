@@ -0,0 +1,262 @@
+#include "HoldLedger.h"
+#include "BalanceFeed.h"
+#include "Journal.h"
+#include "AccountEvents.h"
+#include "Transaction.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    constexpr auto kTick = std::chrono::seconds(1);
+}
+
+HoldLedger& HoldLedger::instance() {
+    static HoldLedger ledger;
+    return ledger;
+}
+
+HoldLedger::HoldLedger() : epoch(std::chrono::steady_clock::now()), wheel(kWheelSlots), expirer([this] { run(); }) {}
+
+HoldLedger::~HoldLedger() {
+    stop();
+}
+
+void HoldLedger::stop() {
+    {
+        std::lock_guard<std::mutex> lock(wheelMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (expirer.joinable()) {
+        expirer.join();
+    }
+}
+
+void HoldLedger::setBalance(int accountID, double balance) {
+    Book& book = books.get(accountID);
+    std::lock_guard<std::mutex> lock(book.mutex);
+    book.known = true;
+    book.balance = balance;
+}
+
+void HoldLedger::seedBalance(int accountID, double balance) {
+    Book& book = books.get(accountID);
+    std::lock_guard<std::mutex> lock(book.mutex);
+    if (!book.known) {
+        book.known = true;
+        book.balance = balance;
+    }
+}
+
+uint64_t HoldLedger::place(int accountID, double amount, std::chrono::seconds ttl) {
+    if (!(amount > 0.0) || Journal::toCents(amount) <= 0) {
+        return 0;
+    }
+    const int64_t expiresAt = now() + std::max<int64_t>(1, ttl.count());
+
+    Book* found = books.find(accountID);
+    if (!found) {
+        return 0;
+    }
+    Book& book = *found;
+    uint64_t holdID;
+    {
+        std::lock_guard<std::mutex> lock(book.mutex);
+        if (!book.known || book.balance - book.held < amount) {
+            return 0;
+        }
+        const uint32_t sequence = book.nextSequence++;
+        if (book.nextSequence == 0) {
+            book.nextSequence = 1;
+        }
+        book.holds.push_back(Hold{ sequence, amount, expiresAt });
+        book.held += amount;
+        holdID = (static_cast<uint64_t>(static_cast<uint32_t>(accountID)) << 32) | sequence;
+    }
+    schedule(holdID, expiresAt);
+    return holdID;
+}
+
+bool HoldLedger::release(uint64_t holdID) {
+    Book* book = books.find(accountOf(holdID));
+    if (!book) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    auto it = findHold(*book, holdID);
+    if (it == book->holds.end()) {
+        return false;
+    }
+    removeHold(*book, it);
+    return true;
+}
+
+double HoldLedger::heldAmount(uint64_t holdID) {
+    Book* book = books.find(accountOf(holdID));
+    if (!book) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    auto it = findHold(*book, holdID);
+    return it == book->holds.end() ? 0.0 : it->amount;
+}
+
+/**
+ * @brief Each account's settled total is posted to the journal as one withdrawal after its book
+ * is unlocked, and recorded as one Withdrawn event. The journal's balance is then published once per account, which also moves the
+ * account's delta-sync log, its WebSocket subscribers and this book. The total is also published as one "settlement"
+ * transaction, which stores it and adds it to the account's transaction feed and change log.
+ */
+std::vector<HoldLedger::Posting> HoldLedger::settle(const std::vector<Settlement>& batch) {
+    std::vector<Posting> postings(batch.size());
+    std::vector<std::size_t> order(batch.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&batch](std::size_t a, std::size_t b) {
+        return accountOf(batch[a].holdID) < accountOf(batch[b].holdID);
+    });
+
+    // one transaction ID for each account in the batch, taken before any book changes, since the
+    // first call reads Firestore and may throw
+    std::vector<int> transactionIDs;
+    for (std::size_t i = 0; i < order.size(); i++) {
+        if (i == 0 || accountOf(batch[order[i]].holdID) != accountOf(batch[order[i - 1]].holdID)) {
+            transactionIDs.push_back(Transaction::nextTransactionID());
+        }
+    }
+
+    struct Change {
+        int accountID;
+        int transactionID;
+        double balanceBefore;
+        double settled;
+    };
+    std::vector<Change> changed;
+    std::size_t account = 0;
+    for (std::size_t i = 0; i < order.size(); account++) {
+        const int accountID = accountOf(batch[order[i]].holdID);
+        Book* found = books.find(accountID);
+        if (!found) {
+            // no hold was ever placed on the account
+            for (; i < order.size() && accountOf(batch[order[i]].holdID) == accountID; i++) {
+                postings[order[i]] = Posting{ batch[order[i]].holdID, accountID, false, 0.0 };
+            }
+            continue;
+        }
+        Book& book = *found;
+        std::lock_guard<std::mutex> lock(book.mutex);
+        const double balanceBefore = book.balance;
+        bool posted = false;
+        for (; i < order.size() && accountOf(batch[order[i]].holdID) == accountID; i++) {
+            const Settlement& settlement = batch[order[i]];
+            Posting& posting = postings[order[i]];
+            posting = Posting{ settlement.holdID, accountID, false, book.balance };
+
+            auto it = findHold(book, settlement.holdID);
+            if (it == book.holds.end() || !(settlement.amount > 0.0) || Journal::toCents(settlement.amount) <= 0 || settlement.amount > it->amount) {
+                continue;
+            }
+            book.balance -= settlement.amount;
+            removeHold(book, it);
+            posting.settled = true;
+            posting.balanceAfter = book.balance;
+            posted = true;
+        }
+        if (posted) {
+            changed.push_back(Change{ accountID, transactionIDs[account], balanceBefore, balanceBefore - book.balance });
+        }
+    }
+
+    Journal& journal = Journal::instance();
+    AccountEvents& events = AccountEvents::instance();
+    const std::string date = Transaction::today();
+    for (const auto& change : changed) {
+        journal.open(change.accountID, change.balanceBefore);
+        // the holds already reserved the money, so settlement may take the account below zero
+        Journal::Entry entry = Journal::withdrawal(change.accountID, change.settled);
+        entry.allowOverdraft = true;
+        journal.post(std::move(entry));
+        // not recorded for an account the event store has never opened
+        events.withdrawn(change.accountID, change.settled);
+        const double balance = journal.balance(change.accountID);
+        BalanceFeed::instance().publish(change.accountID, balance);
+        Transaction(change.transactionID, change.accountID, "settlement", -change.settled, date, balance).publish();
+    }
+    return postings;
+}
+
+HoldLedger::Balances HoldLedger::balances(int accountID) {
+    Book* book = books.find(accountID);
+    if (!book) {
+        return Balances{};
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return Balances{ book->known, book->balance, book->held, book->balance - book->held, book->holds.size() };
+}
+
+std::vector<HoldLedger::Hold>::iterator HoldLedger::findHold(Book& book, uint64_t holdID) {
+    const uint32_t sequence = static_cast<uint32_t>(holdID);
+    return std::find_if(book.holds.begin(), book.holds.end(), [sequence](const Hold& hold) { return hold.sequence == sequence; });
+}
+
+void HoldLedger::removeHold(Book& book, std::vector<Hold>::iterator hold) {
+    book.held -= hold->amount;
+    *hold = book.holds.back();
+    book.holds.pop_back();
+    if (book.holds.empty()) {
+        book.held = 0.0; // no rounding drift outlives the last hold
+    }
+}
+
+int64_t HoldLedger::now() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void HoldLedger::schedule(uint64_t holdID, int64_t expiresAt) {
+    std::lock_guard<std::mutex> lock(wheelMutex);
+    wheel[static_cast<std::size_t>(expiresAt) % kWheelSlots].push_back(holdID);
+}
+
+/**
+ * @brief Turns the wheel once per tick. A slot is taken out of the wheel before its holds are
+ * looked at, so placing holds never waits on expiry.
+ */
+void HoldLedger::run() {
+    std::unique_lock<std::mutex> lock(wheelMutex);
+    while (!wake.wait_for(lock, kTick, [this] { return stopping; })) {
+        const int64_t current = now();
+        while (turnedTo < current && !stopping) {
+            turnedTo++;
+            std::vector<uint64_t> due;
+            due.swap(wheel[static_cast<std::size_t>(turnedTo) % kWheelSlots]);
+            lock.unlock();
+            expire(due, turnedTo);
+            lock.lock();
+            // holds due on a later turn go back to the same slot
+            auto& slot = wheel[static_cast<std::size_t>(turnedTo) % kWheelSlots];
+            slot.insert(slot.end(), due.begin(), due.end());
+        }
+    }
+}
+
+/**
+ * @brief Removes the holds in `due` that have expired and leaves only those due later in it.
+ * Holds already released or settled are dropped from the wheel here.
+ */
+void HoldLedger::expire(std::vector<uint64_t>& due, int64_t tick) {
+    std::size_t kept = 0;
+    for (uint64_t holdID : due) {
+        Book& book = *books.find(accountOf(holdID)); // the hold was placed, so its book exists
+        std::lock_guard<std::mutex> lock(book.mutex);
+        auto it = findHold(book, holdID);
+        if (it == book.holds.end()) {
+            continue;
+        }
+        if (it->expiresAt > tick) {
+            due[kept++] = holdID;
+            continue;
+        }
+        removeHold(book, it);
+    }
+    due.resize(kept);
+}
@@ -0,0 +1,255 @@
+#include "Journal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+Journal& Journal::instance() {
+    static Journal journal;
+    return journal;
+}
+
+int64_t Journal::toCents(double amount) {
+    return std::llround(amount * 100.0);
+}
+
+double Journal::fromCents(int64_t cents) {
+    return static_cast<double>(cents) / 100.0;
+}
+
+Journal::Entry Journal::transfer(int fromAccountID, int toAccountID, double amount) {
+    // a negative amount would run the entry backwards, and zero cents would record nothing
+    if (!std::isfinite(amount) || toCents(amount) <= 0) {
+        throw std::invalid_argument("journal amount must be a positive number of cents");
+    }
+    const int64_t cents = toCents(amount);
+    return Entry{ { Leg{ fromAccountID, -cents }, Leg{ toAccountID, cents } } };
+}
+
+Journal::Entry Journal::deposit(int accountID, double amount) {
+    return transfer(kExternalAccount, accountID, amount);
+}
+
+Journal::Entry Journal::withdrawal(int accountID, double amount) {
+    return transfer(accountID, kExternalAccount, amount);
+}
+
+void Journal::open(int accountID, double balance) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    if (projections.count(accountID)) {
+        return;
+    }
+    const int64_t cents = toCents(balance);
+    projections[accountID] = 0;
+    if (cents != 0) {
+        append(Entry{ { Leg{ accountID, cents }, Leg{ kOpeningEquityAccount, -cents } } });
+    }
+}
+
+/**
+ * @brief The first caller to find no commit running commits the queue; the others wait for it.
+ * Entries queued while it works are committed by the first of their callers, which it wakes.
+ */
+uint64_t Journal::post(Entry entry) {
+    check(entry);
+
+    Request request;
+    request.entry = std::move(entry);
+
+    std::unique_lock<std::mutex> lock(queueMutex);
+    queue.push_back(&request);
+    if (committing) {
+        committed.wait(lock, [&request] { return request.done || request.leads; });
+        if (request.done) {
+            return request.sequence;
+        }
+    }
+
+    // this caller's entry is still queued, so it is in the batch
+    committing = true;
+    std::vector<Request*> batch;
+    batch.swap(queue);
+    lock.unlock();
+    commit(batch);
+    lock.lock();
+    for (Request* queued : batch) {
+        queued->done = true;
+    }
+    if (queue.empty()) {
+        committing = false;
+    } else {
+        queue.front()->leads = true;
+    }
+    committed.notify_all();
+    return request.sequence;
+}
+
+double Journal::balance(int accountID) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    auto it = projections.find(accountID);
+    return it == projections.end() ? 0.0 : fromCents(it->second);
+}
+
+/**
+ * @brief Takes the cut under the lock: the number of entries, the chunks holding them and the
+ * projections at that point. The scan itself runs without the lock while posting goes on.
+ */
+Journal::VerifyResult Journal::verify(std::size_t threads) {
+    const auto started = std::chrono::steady_clock::now();
+    uint64_t entries;
+    uint64_t legs;
+    std::vector<const LegChunk*> legView;
+    std::vector<const EntryChunk*> entryView;
+    std::unordered_map<int, int64_t> expected;
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        entries = entryCount;
+        legs = legCount;
+        for (const auto& chunk : legChunks) {
+            legView.push_back(chunk.get());
+        }
+        for (const auto& chunk : entryChunks) {
+            entryView.push_back(chunk.get());
+        }
+        expected = projections;
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<std::size_t>(std::max<uint64_t>(1, std::min<uint64_t>(threads, entries / 4096 + 1)));
+
+    struct Partial {
+        std::unordered_map<int, int64_t> sums;
+        uint64_t unbalanced = 0;
+    };
+    std::vector<Partial> partials(threads);
+
+    auto scan = [&](std::size_t part) {
+        Partial& partial = partials[part];
+        const uint64_t begin = entries * part / threads;
+        const uint64_t end = entries * (part + 1) / threads;
+        for (uint64_t e = begin; e < end; e++) {
+            const EntrySpan& span = entryView[e / kChunkSize]->entries[e % kChunkSize];
+            int64_t total = 0;
+            for (uint64_t l = span.firstLeg; l < span.firstLeg + span.legCount; l++) {
+                const Leg& leg = legView[l / kChunkSize]->legs[l % kChunkSize];
+                partial.sums[leg.accountID] += leg.cents;
+                total += leg.cents;
+            }
+            if (total != 0) {
+                partial.unbalanced++;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t part = 1; part < threads; part++) {
+        workers.emplace_back(scan, part);
+    }
+    scan(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    VerifyResult result;
+    result.entries = entries;
+    result.legs = legs;
+    std::unordered_map<int, int64_t>& derived = partials[0].sums;
+    result.unbalancedEntries = partials[0].unbalanced;
+    for (std::size_t part = 1; part < threads; part++) {
+        for (const auto& sum : partials[part].sums) {
+            derived[sum.first] += sum.second;
+        }
+        result.unbalancedEntries += partials[part].unbalanced;
+    }
+
+    auto report = [&result](int accountID, int64_t journalCents, int64_t projectionCents) {
+        if (result.mismatches.size() < kMaxReportedMismatches) {
+            result.mismatches.push_back(Mismatch{ accountID, journalCents, projectionCents });
+        }
+    };
+    bool matched = true;
+    for (const auto& sum : derived) {
+        auto it = expected.find(sum.first);
+        const int64_t projected = it == expected.end() ? 0 : it->second;
+        if (projected != sum.second) {
+            matched = false;
+            report(sum.first, sum.second, projected);
+        }
+    }
+    for (const auto& projection : expected) {
+        if (projection.second != 0 && !derived.count(projection.first)) {
+            matched = false;
+            report(projection.first, 0, projection.second);
+        }
+    }
+
+    result.accounts = derived.size();
+    result.ok = matched && result.unbalancedEntries == 0;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+void Journal::check(const Entry& entry) {
+    if (entry.legs.size() < 2) {
+        throw std::invalid_argument("journal entry needs at least two legs");
+    }
+    int64_t total = 0;
+    for (const Leg& leg : entry.legs) {
+        if (leg.cents == 0) {
+            throw std::invalid_argument("journal entry has a leg of zero cents");
+        }
+        total += leg.cents;
+    }
+    if (total != 0) {
+        throw std::invalid_argument("journal entry does not balance");
+    }
+}
+
+void Journal::commit(std::vector<Request*>& batch) {
+    std::lock_guard<std::mutex> lock(journalMutex);
+    for (Request* request : batch) {
+        const Entry& entry = request->entry;
+        bool funded = true;
+        if (!entry.allowOverdraft) {
+            for (const Leg& leg : entry.legs) {
+                if (leg.cents >= 0 || leg.accountID < 0) {
+                    continue;
+                }
+                // an account may appear in more than one leg, so net them before checking
+                int64_t net = 0;
+                for (const Leg& other : entry.legs) {
+                    if (other.accountID == leg.accountID) {
+                        net += other.cents;
+                    }
+                }
+                auto it = projections.find(leg.accountID);
+                if ((it == projections.end() ? 0 : it->second) + net < 0) {
+                    funded = false;
+                    break;
+                }
+            }
+        }
+        request->sequence = funded ? append(entry) : 0;
+    }
+}
+
+uint64_t Journal::append(const Entry& entry) {
+    if (entryCount == entryChunks.size() * kChunkSize) {
+        entryChunks.push_back(std::make_unique<EntryChunk>());
+    }
+    entryChunks.back()->entries[entryCount % kChunkSize] = EntrySpan{ legCount, static_cast<uint32_t>(entry.legs.size()) };
+
+    for (const Leg& leg : entry.legs) {
+        if (legCount == legChunks.size() * kChunkSize) {
+            legChunks.push_back(std::make_unique<LegChunk>());
+        }
+        legChunks.back()->legs[legCount % kChunkSize] = leg;
+        legCount++;
+        projections[leg.accountID] += leg.cents;
+    }
+    return ++entryCount;
+}
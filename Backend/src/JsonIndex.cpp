@@ -0,0 +1,599 @@
+#include "JsonIndex.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_INDEX_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr int kMaxDepth = 64;
+    constexpr size_t kBlock = 16;
+
+    inline bool isWhitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    inline int countTrailingZeros(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    /**
+     * @brief Marks every quote, backslash and structural character in a block of up to 16 bytes.
+     * @return A bit mask with bit i set when p[i] is one of " \ { } [ ] : ,
+     */
+    inline uint32_t classifyBlock(const char* p, size_t length) {
+        char padded[kBlock];
+        if (length < kBlock) {
+            std::memset(padded, ' ', kBlock);
+            std::memcpy(padded, p, length);
+            p = padded;
+        }
+#ifdef JSON_INDEX_SSE2
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // '[' and ']' differ from '{' and '}' only in bit 0x20
+        const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+        hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+        return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kBlock; i++) {
+            char c = p[i];
+            if (c == '"' || c == '\\' || c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')
+                mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+
+    /**
+     * @brief Checks that a byte range is well-formed UTF-8 (no overlongs, surrogates or values past U+10FFFF).
+     * @details Pure-ASCII blocks are skipped 16 bytes at a time.
+     */
+    bool isValidUtf8(std::string_view text) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+        const size_t n = text.size();
+        size_t i = 0;
+        while (i < n) {
+#ifdef JSON_INDEX_SSE2
+            if (i + kBlock <= n) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                if (_mm_movemask_epi8(v) == 0) {
+                    i += kBlock;
+                    continue;
+                }
+            }
+#endif
+            unsigned char c = p[i];
+            if (c < 0x80) {
+                i++;
+                continue;
+            }
+
+            size_t length;
+            unsigned char low = 0x80, high = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) {
+                length = 2;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                length = 3;
+                if (c == 0xE0) low = 0xA0;       // overlong
+                else if (c == 0xED) high = 0x9F; // UTF-16 surrogates
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                length = 4;
+                if (c == 0xF0) low = 0x90;       // overlong
+                else if (c == 0xF4) high = 0x8F; // past U+10FFFF
+            } else {
+                return false;
+            }
+
+            if (i + length > n)
+                return false;
+            if (p[i + 1] < low || p[i + 1] > high)
+                return false;
+            for (size_t k = 2; k < length; k++) {
+                if ((p[i + k] & 0xC0) != 0x80)
+                    return false;
+            }
+            i += length;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks a number against the JSON grammar: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+     */
+    bool isValidNumber(std::string_view text) {
+        size_t i = 0;
+        const size_t n = text.size();
+        auto digit = [&](size_t k) { return k < n && text[k] >= '0' && text[k] <= '9'; };
+
+        if (i < n && text[i] == '-')
+            i++;
+        if (!digit(i))
+            return false;
+        if (text[i] == '0') {
+            i++;
+        } else {
+            while (digit(i))
+                i++;
+        }
+        if (i < n && text[i] == '.') {
+            i++;
+            if (!digit(i))
+                return false;
+            while (digit(i))
+                i++;
+        }
+        if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+            i++;
+            if (i < n && (text[i] == '+' || text[i] == '-'))
+                i++;
+            if (!digit(i))
+                return false;
+            while (digit(i))
+                i++;
+        }
+        return i == n;
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool readHex4(std::string_view text, size_t at, uint32_t& out) {
+        if (at + 4 > text.size())
+            return false;
+        out = 0;
+        for (size_t k = 0; k < 4; k++) {
+            int h = hexValue(text[at + k]);
+            if (h < 0)
+                return false;
+            out = (out << 4) | static_cast<uint32_t>(h);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks the characters between two quotes: no raw control characters and only valid escapes.
+     */
+    bool isValidStringBody(std::string_view body) {
+        for (size_t i = 0; i < body.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(body[i]);
+            if (c < 0x20)
+                return false;
+            if (c != '\\')
+                continue;
+            if (++i >= body.size())
+                return false;
+            switch (body[i]) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u': {
+                    uint32_t unit;
+                    if (!readHex4(body, i + 1, unit))
+                        return false;
+                    i += 4;
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void appendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    /**
+     * @brief Decodes an already validated string body into UTF-8.
+     * @details Unpaired surrogates become U+FFFD.
+     */
+    void decodeString(std::string_view body, std::string& out) {
+        out.clear();
+        if (body.find('\\') == std::string_view::npos) {
+            out.assign(body.data(), body.size());
+            return;
+        }
+        out.reserve(body.size());
+        for (size_t i = 0; i < body.size(); i++) {
+            char c = body[i];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            char e = body[++i];
+            switch (e) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    readHex4(body, i + 1, cp);
+                    i += 4;
+                    if (cp >= 0xD800 && cp <= 0xDBFF) {
+                        uint32_t low;
+                        if (i + 2 < body.size() && body[i + 1] == '\\' && body[i + 2] == 'u' && readHex4(body, i + 3, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        } else {
+                            cp = 0xFFFD;
+                        }
+                    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                        cp = 0xFFFD;
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: out += e; break; // " \ /
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stage one: records the offsets of quotes and of structural characters outside strings.
+ * @details Backslashes are tracked so that an escaped quote never ends a string. Anything that
+ * is not indexed (numbers, literals, stray characters) lies in the gaps between tokens and is
+ * checked by stage two.
+ */
+void JsonIndex::buildIndex() {
+    tokens.clear();
+    bool inString = false;
+    size_t escaped = std::numeric_limits<size_t>::max();
+
+    for (size_t block = 0; block < json.size(); block += kBlock) {
+        uint32_t mask = classifyBlock(json.data() + block, std::min(kBlock, json.size() - block));
+        while (mask) {
+            size_t pos = block + countTrailingZeros(mask);
+            mask &= mask - 1;
+            char c = json[pos];
+
+            if (inString) {
+                if (pos == escaped)
+                    continue;
+                if (c == '\\') {
+                    escaped = pos + 1;
+                } else if (c == '"') {
+                    inString = false;
+                    tokens.push_back(static_cast<uint32_t>(pos));
+                }
+            } else if (c == '"') {
+                inString = true;
+                tokens.push_back(static_cast<uint32_t>(pos));
+            } else if (c != '\\') {
+                tokens.push_back(static_cast<uint32_t>(pos));
+            }
+        }
+    }
+    unterminatedString = inString;
+}
+
+JsonIndex::JsonIndex(std::pmr::memory_resource* resource)
+    : tokens(resource ? resource : std::pmr::get_default_resource()), members(resource ? resource : std::pmr::get_default_resource()) {}
+
+bool JsonIndex::parse(std::string_view document) {
+    json = document;
+    members.clear();
+
+    if (json.size() >= std::numeric_limits<uint32_t>::max())
+        return false;
+    if (!isValidUtf8(json))
+        return false;
+
+    buildIndex();
+    if (unterminatedString || tokens.empty())
+        return false;
+
+    size_t token = 0, cursor = 0;
+    for (size_t i = 0; i < tokens[0]; i++) {
+        if (!isWhitespace(json[i]))
+            return false;
+    }
+    if (json[tokens[0]] != '{')
+        return false;
+    if (!parseValue(token, cursor, 0, nullptr))
+        return false;
+
+    if (token != tokens.size())
+        return false;
+    for (size_t i = cursor; i < json.size(); i++) {
+        if (!isWhitespace(json[i]))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stage two: validates one value starting at the current token.
+ * @param token Index of the next unconsumed token; advanced past the value.
+ * @param cursor Byte offset just after the last consumed character; advanced past the value.
+ * @param depth Nesting depth of the value.
+ * @param member When set, receives the kind and byte range of the value.
+ */
+bool JsonIndex::parseValue(size_t& token, size_t& cursor, int depth, Member* member) {
+    size_t next = token < tokens.size() ? tokens[token] : json.size();
+    size_t begin = cursor;
+    while (begin < next && isWhitespace(json[begin]))
+        begin++;
+
+    if (begin < next) {
+        // Numbers and literals have no token of their own; they fill the gap up to the next one
+        size_t end = next;
+        while (end > begin && isWhitespace(json[end - 1]))
+            end--;
+        std::string_view text = json.substr(begin, end - begin);
+
+        Kind kind;
+        if (isValidNumber(text))
+            kind = Kind::Number;
+        else if (text == "true" || text == "false" || text == "null")
+            kind = Kind::Literal;
+        else
+            return false;
+
+        if (member) {
+            member->kind = kind;
+            member->valueBegin = static_cast<uint32_t>(begin);
+            member->valueEnd = static_cast<uint32_t>(end);
+        }
+        cursor = next;
+        return true;
+    }
+
+    if (token >= tokens.size())
+        return false;
+
+    char c = json[next];
+    if (c == '"') {
+        if (token + 1 >= tokens.size())
+            return false;
+        size_t close = tokens[token + 1];
+        if (!isValidStringBody(json.substr(next + 1, close - next - 1)))
+            return false;
+        if (member) {
+            member->kind = Kind::String;
+            member->valueBegin = static_cast<uint32_t>(next + 1);
+            member->valueEnd = static_cast<uint32_t>(close);
+        }
+        token += 2;
+        cursor = close + 1;
+        return true;
+    }
+
+    if (c == '{' || c == '[') {
+        if (depth >= kMaxDepth)
+            return false;
+        token++;
+        cursor = next + 1;
+        if (!parseContainer(token, cursor, depth + 1, c == '{' ? '}' : ']'))
+            return false;
+        if (member) {
+            member->kind = c == '{' ? Kind::Object : Kind::Array;
+            member->valueBegin = static_cast<uint32_t>(next);
+            member->valueEnd = static_cast<uint32_t>(cursor);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Validates the members of an object or the elements of an array after its opening token.
+ * @details Members of the root object (depth 1) are recorded for the getters.
+ */
+bool JsonIndex::parseContainer(size_t& token, size_t& cursor, int depth, char close) {
+    const bool isObject = close == '}';
+    const bool isRoot = isObject && depth == 1;
+
+    size_t peekToken = token, peekCursor = cursor;
+    if (expect(peekToken, peekCursor, close)) {
+        token = peekToken;
+        cursor = peekCursor;
+        return true;
+    }
+
+    while (true) {
+        Member member{};
+        if (isObject) {
+            if (!expect(token, cursor, '"') || token >= tokens.size())
+                return false;
+            size_t keyBegin = cursor;
+            size_t keyEnd = tokens[token];
+            if (!isValidStringBody(json.substr(keyBegin, keyEnd - keyBegin)))
+                return false;
+            member.keyBegin = static_cast<uint32_t>(keyBegin);
+            member.keyEnd = static_cast<uint32_t>(keyEnd);
+            token++;
+            cursor = keyEnd + 1;
+            if (!expect(token, cursor, ':'))
+                return false;
+        }
+
+        if (!parseValue(token, cursor, depth, isRoot ? &member : nullptr))
+            return false;
+        if (isRoot)
+            members.push_back(member);
+
+        if (expect(token, cursor, close))
+            return true;
+        if (!expect(token, cursor, ','))
+            return false;
+    }
+}
+
+/**
+ * @brief Consumes the next token if it is 'c' and only whitespace precedes it.
+ */
+bool JsonIndex::expect(size_t& token, size_t& cursor, char c) {
+    if (token >= tokens.size())
+        return false;
+    size_t at = tokens[token];
+    if (json[at] != c)
+        return false;
+    for (size_t i = cursor; i < at; i++) {
+        if (!isWhitespace(json[i]))
+            return false;
+    }
+    token++;
+    cursor = at + 1;
+    return true;
+}
+
+const JsonIndex::Member* JsonIndex::find(std::string_view key) const {
+    std::string decoded;
+    for (const Member& member : members) {
+        std::string_view raw = json.substr(member.keyBegin, member.keyEnd - member.keyBegin);
+        if (raw == key)
+            return &member;
+        if (raw.find('\\') != std::string_view::npos) {
+            decodeString(raw, decoded);
+            if (decoded == key)
+                return &member;
+        }
+    }
+    return nullptr;
+}
+
+bool JsonIndex::getString(std::string_view key, std::string& out) const {
+    const Member* member = find(key);
+    if (!member || member->kind != Kind::String)
+        return false;
+    decodeString(json.substr(member->valueBegin, member->valueEnd - member->valueBegin), out);
+    return true;
+}
+
+bool JsonIndex::getDouble(std::string_view key, double& out) const {
+    const Member* member = find(key);
+    if (!member || member->kind != Kind::Number)
+        return false;
+    const char* begin = json.data() + member->valueBegin;
+    const char* end = json.data() + member->valueEnd;
+    auto result = std::from_chars(begin, end, out);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+bool JsonIndex::has(std::string_view key) const {
+    return find(key) != nullptr;
+}
+
+bool JsonIndex::getElements(std::string_view key, std::pmr::vector<std::string_view>& out) const {
+    out.clear();
+    const Member* member = find(key);
+    if (!member || member->kind != Kind::Array)
+        return false;
+
+    // The array is already validated, so its elements are split by the commas at its own depth.
+    // Tokens inside strings are only the quotes, which never change the depth.
+    size_t token = std::lower_bound(tokens.begin(), tokens.end(), member->valueBegin) - tokens.begin();
+    size_t elementBegin = member->valueBegin + 1;
+    int depth = 0;
+    for (; token < tokens.size() && tokens[token] < member->valueEnd; token++) {
+        const size_t at = tokens[token];
+        const char c = json[at];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        }
+        if ((c == ',' && depth == 1) || depth == 0) {
+            size_t begin = elementBegin, end = at;
+            while (begin < end && isWhitespace(json[begin]))
+                begin++;
+            while (end > begin && isWhitespace(json[end - 1]))
+                end--;
+            if (begin < end)
+                out.push_back(json.substr(begin, end - begin));
+            elementBegin = at + 1;
+        }
+    }
+    return true;
+}
+
+bool TransferRequest::parse(std::string_view body, TransferRequest& out, std::pmr::memory_resource* scratch) {
+    // In the request's arena when there is one; otherwise one index per worker thread, so its
+    // buffers are reused across requests
+    thread_local JsonIndex shared;
+    JsonIndex local(scratch);
+    JsonIndex& index = scratch ? local : shared;
+    if (!index.parse(body))
+        return false;
+    return index.getString("senderId", out.senderId)
+        && index.getString("recipientId", out.recipientId)
+        && index.getDouble("amount", out.amount);
+}
+
+bool HoldRequest::parse(std::string_view body, HoldRequest& out, std::pmr::memory_resource* scratch) {
+    thread_local JsonIndex shared;
+    JsonIndex local(scratch);
+    JsonIndex& index = scratch ? local : shared;
+    if (!index.parse(body))
+        return false;
+    if (!index.getDouble("amount", out.amount))
+        return false;
+    out.ttlSeconds = 0.0;
+    return index.getDouble("ttlSeconds", out.ttlSeconds) || !index.has("ttlSeconds");
+}
+
+bool SettleRequest::parse(std::string_view body, SettleRequest& out, std::pmr::memory_resource* scratch) {
+    thread_local JsonIndex sharedIndex;
+    thread_local JsonIndex sharedElement;
+    thread_local std::pmr::vector<std::string_view> sharedElements;
+    JsonIndex localIndex(scratch);
+    JsonIndex localElement(scratch);
+    std::pmr::vector<std::string_view> localElements(scratch ? scratch : std::pmr::get_default_resource());
+    JsonIndex& index = scratch ? localIndex : sharedIndex;
+    JsonIndex& element = scratch ? localElement : sharedElement;
+    std::pmr::vector<std::string_view>& elements = scratch ? localElements : sharedElements;
+    if (!index.parse(body))
+        return false;
+    if (!index.getElements("settlements", elements))
+        return false;
+
+    out.settlements.resize(elements.size());
+    for (size_t i = 0; i < elements.size(); i++) {
+        Settlement& settlement = out.settlements[i];
+        if (!element.parse(elements[i]) || !element.getString("holdID", settlement.holdID) || !element.getDouble("amount", settlement.amount))
+            return false;
+    }
+    return true;
+}
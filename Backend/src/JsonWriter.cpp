@@ -0,0 +1,141 @@
+#include "JsonWriter.h"
+
+#include <charconv>
+#include <cmath>
+
+template <typename String>
+void BasicJsonWriter<String>::beginObject() {
+    separate();
+    out += '{';
+    depth++;
+    hasMembers &= ~(uint64_t(1) << (depth & 63));
+}
+
+template <typename String>
+void BasicJsonWriter<String>::endObject() {
+    out += '}';
+    depth--;
+}
+
+template <typename String>
+void BasicJsonWriter<String>::beginArray() {
+    separate();
+    out += '[';
+    depth++;
+    hasMembers &= ~(uint64_t(1) << (depth & 63));
+}
+
+template <typename String>
+void BasicJsonWriter<String>::endArray() {
+    out += ']';
+    depth--;
+}
+
+template <typename String>
+void BasicJsonWriter<String>::key(std::string_view name) {
+    separate();
+    out += '"';
+    appendEscaped(out, name);
+    out += "\":";
+    afterKey = true;
+}
+
+template <typename String>
+void BasicJsonWriter<String>::value(std::string_view text) {
+    separate();
+    out += '"';
+    appendEscaped(out, text);
+    out += '"';
+}
+
+template <typename String>
+void BasicJsonWriter<String>::value(bool flag) {
+    separate();
+    out += flag ? "true" : "false";
+}
+
+template <typename String>
+void BasicJsonWriter<String>::value(int64_t number) {
+    separate();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+/**
+ * @brief Writes a double in its shortest round-trip form; NaN and infinity become null.
+ */
+template <typename String>
+void BasicJsonWriter<String>::value(double number) {
+    if (!std::isfinite(number)) {
+        null();
+        return;
+    }
+    separate();
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+template <typename String>
+void BasicJsonWriter<String>::null() {
+    separate();
+    out += "null";
+}
+
+template <typename String>
+void BasicJsonWriter<String>::raw(std::string_view json) {
+    separate();
+    out.append(json.data(), json.size());
+}
+
+/**
+ * @brief Writes the comma before a value or member when one is needed.
+ */
+template <typename String>
+void BasicJsonWriter<String>::separate() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    const uint64_t bit = uint64_t(1) << (depth & 63);
+    if (depth > 0 && (hasMembers & bit)) {
+        out += ',';
+    }
+    hasMembers |= bit;
+}
+
+/**
+ * @brief Appends text with JSON escaping, copying runs of safe characters in one go.
+ */
+template <typename String>
+void BasicJsonWriter<String>::appendEscaped(String& out, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+        }
+    }
+    out.append(text.data() + runStart, text.size() - runStart);
+}
+
+template class BasicJsonWriter<std::string>;
+template class BasicJsonWriter<std::pmr::string>;
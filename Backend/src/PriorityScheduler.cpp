@@ -0,0 +1,181 @@
+#include "PriorityScheduler.h"
+
+#include <limits>
+
+namespace {
+    // One round of the weighted round robin: 8 transfer, 4 account read, 2 history, 1 static turns,
+    // interleaved so no priority waits a whole round.
+    constexpr PriorityScheduler::Priority kRound[] = {
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::AccountRead,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::History,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::AccountRead,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::Static,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::AccountRead,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::History,
+        PriorityScheduler::Priority::Transfer, PriorityScheduler::Priority::AccountRead,
+        PriorityScheduler::Priority::Transfer,
+    };
+    constexpr std::size_t kRoundLength = sizeof(kRound) / sizeof(kRound[0]);
+
+    // The worker a submitting thread feeds; each io_service thread gets its own.
+    thread_local std::size_t homeWorker = static_cast<std::size_t>(-1);
+
+    constexpr uint64_t kNoDelay = std::numeric_limits<uint64_t>::max();
+
+    struct RouteEntry {
+        crow::HTTPMethod method;
+        const char* pattern; // '*' matches one path segment
+        PriorityScheduler::Priority priority;
+    };
+
+    // Every route whose priority is not the default for its path; first match wins.
+    constexpr RouteEntry kRoutes[] = {
+        { crow::HTTPMethod::Post, "/api/transfer", PriorityScheduler::Priority::Transfer },
+        { crow::HTTPMethod::Post, "/api/accounts/*/holds", PriorityScheduler::Priority::Transfer },
+        { crow::HTTPMethod::Post, "/api/holds/settle", PriorityScheduler::Priority::Transfer },
+        { crow::HTTPMethod::Delete, "/api/holds/*", PriorityScheduler::Priority::Transfer },
+        { crow::HTTPMethod::Get, "/api/transactions/*", PriorityScheduler::Priority::History },
+        { crow::HTTPMethod::Get, "/api/accounts/*/export", PriorityScheduler::Priority::History },
+        { crow::HTTPMethod::Get, "/api/accounts/*/statements/*", PriorityScheduler::Priority::History },
+        { crow::HTTPMethod::Get, "/api/ledger/verify", PriorityScheduler::Priority::History },
+        { crow::HTTPMethod::Get, "/ws/balances", PriorityScheduler::Priority::AccountRead },
+    };
+
+    bool matches(const char* pattern, const std::string& url) {
+        std::size_t at = 0;
+        for (; *pattern; pattern++) {
+            if (*pattern == '*') {
+                const std::size_t end = url.find('/', at);
+                if (end == at) {
+                    return false;
+                }
+                at = end == std::string::npos ? url.size() : end;
+            } else if (at < url.size() && url[at] == *pattern) {
+                at++;
+            } else {
+                return false;
+            }
+        }
+        return at == url.size();
+    }
+}
+
+PriorityScheduler::PriorityScheduler(unsigned threadCount)
+    : minDelay(kNoDelay),
+      epoch(std::chrono::steady_clock::now()) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        threads.emplace_back([this, i] { run(i); });
+    }
+}
+
+PriorityScheduler::~PriorityScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void PriorityScheduler::submit(Priority priority, std::function<void()> task) {
+    if (homeWorker >= workers.size()) {
+        homeWorker = nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    }
+    Worker& worker = *workers[homeWorker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[static_cast<std::size_t>(priority)].push_back(Task{ std::move(task), std::chrono::steady_clock::now() });
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    {
+        // taking the lock orders this with a worker that is about to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+PriorityScheduler::Priority PriorityScheduler::routePriority(const crow::request& req) {
+    for (const RouteEntry& route : kRoutes) {
+        if (req.method == route.method && matches(route.pattern, req.url)) {
+            return route.priority;
+        }
+    }
+    return req.url.compare(0, 5, "/api/") == 0 ? Priority::AccountRead : Priority::Static;
+}
+
+uint64_t PriorityScheduler::takeQueueDelay() {
+    const int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+    const int64_t since = lastDelaySample.exchange(now, std::memory_order_relaxed);
+    const uint64_t delay = minDelay.exchange(kNoDelay, std::memory_order_relaxed);
+    if (delay != kNoDelay) {
+        return delay;
+    }
+    return queued.load(std::memory_order_relaxed) > 0 ? static_cast<uint64_t>(now - since) : 0;
+}
+
+void PriorityScheduler::recordDelay(std::chrono::steady_clock::duration wait) {
+    const uint64_t delay = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+    uint64_t current = minDelay.load(std::memory_order_relaxed);
+    while (delay < current && !minDelay.compare_exchange_weak(current, delay, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Takes the next task from a worker's queues, starting at the given round-robin slot.
+ *
+ * The first non-empty priority at or after the slot wins, so an empty queue passes its turn on.
+ * The owner takes from the front; thieves take from the back, where the newest work is.
+ */
+bool PriorityScheduler::take(Worker& worker, std::size_t& slot, Task& task, bool steal) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    for (std::size_t i = 0; i < kRoundLength; i++) {
+        auto& queue = worker.queues[static_cast<std::size_t>(kRound[(slot + i) % kRoundLength])];
+        if (queue.empty()) {
+            continue;
+        }
+        if (steal) {
+            task = std::move(queue.back());
+            queue.pop_back();
+        } else {
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        slot = (slot + i + 1) % kRoundLength;
+        return true;
+    }
+    return false;
+}
+
+void PriorityScheduler::run(std::size_t self) {
+    homeWorker = self;
+    std::size_t slot = 0;
+    Task task;
+    for (;;) {
+        bool found = take(*workers[self], slot, task, false);
+        for (std::size_t i = 1; !found && i < workers.size(); i++) {
+            found = take(*workers[(self + i) % workers.size()], slot, task, true);
+        }
+
+        if (found) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            recordDelay(std::chrono::steady_clock::now() - task.queuedAt);
+            task.run();
+            task.run = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
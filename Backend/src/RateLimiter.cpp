@@ -0,0 +1,122 @@
+#include "RateLimiter.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+    constexpr std::size_t kSlots = 1 << 16;
+    constexpr uint64_t kTokenBits = 24;
+    constexpr uint64_t kTokenMask = (uint64_t(1) << kTokenBits) - 1;
+    constexpr uint64_t kOneToken = 256;
+
+    uint64_t hashKey(std::string_view text) {
+        uint64_t h = std::hash<std::string_view>()(text);
+        // spread the bits; std::hash may be the identity on some standard libraries
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    uint64_t maxTokens(const RateLimiter::Limit& limit) {
+        return std::min<uint64_t>(static_cast<uint64_t>(limit.burst * kOneToken), kTokenMask);
+    }
+
+    // Tokens in the bucket at nowMs, in 1/256 units; a zero state is a full bucket.
+    uint64_t tokensAt(uint64_t state, const RateLimiter::Limit& limit, uint64_t nowMs) {
+        const uint64_t full = maxTokens(limit);
+        if (state == 0) {
+            return full;
+        }
+        const uint64_t last = state >> kTokenBits;
+        const uint64_t elapsed = nowMs > last ? nowMs - last : 0;
+        const double refill = static_cast<double>(elapsed) * limit.perSecond * kOneToken / 1000.0;
+        if (refill >= static_cast<double>(full)) {
+            return full;
+        }
+        return std::min(full, (state & kTokenMask) + static_cast<uint64_t>(refill));
+    }
+}
+
+std::atomic<uint64_t> RateLimiter::rejectedCount{ 0 };
+
+RateLimiter::BucketTable::BucketTable(std::size_t count)
+    : slots(new Slot[count]), mask(count - 1) {}
+
+bool RateLimiter::BucketTable::tryAcquire(uint64_t key, const Limit& limit, uint64_t nowMs) {
+    if (key == 0) {
+        key = 1;
+    }
+
+    Slot* slot = nullptr;
+    Slot* idle = nullptr;
+    uint64_t idleKey = 0;
+    for (int i = 0; i < kProbe && !slot; i++) {
+        Slot& candidate = slots[(key + i) & mask];
+        uint64_t current = candidate.key.load(std::memory_order_acquire);
+        if (current == 0 && candidate.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+            slot = &candidate;
+        } else if (current == key) {
+            slot = &candidate;
+        } else if (!idle && tokensAt(candidate.state.load(std::memory_order_relaxed), limit, nowMs) == maxTokens(limit)) {
+            // a full bucket holds no history, so its slot can go to a new key
+            idle = &candidate;
+            idleKey = current;
+        }
+    }
+    if (!slot && idle && idle->key.compare_exchange_strong(idleKey, key, std::memory_order_acq_rel)) {
+        idle->state.store(0, std::memory_order_relaxed);
+        slot = idle;
+    }
+    if (!slot) {
+        // every probed slot is busy; fail open rather than reject an unknown client
+        return true;
+    }
+
+    uint64_t state = slot->state.load(std::memory_order_relaxed);
+    for (;;) {
+        const uint64_t tokens = tokensAt(state, limit, nowMs);
+        if (tokens < kOneToken) {
+            return false;
+        }
+        const uint64_t next = (nowMs << kTokenBits) | (tokens - kOneToken);
+        if (slot->state.compare_exchange_weak(state, next, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+RateLimiter::RateLimiter()
+    : ipBuckets(kSlots), start(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief Spends a token for the client IP; answers 429 when it is out.
+ */
+void RateLimiter::before_handle(crow::request& req, crow::response& res, context& /*ctx*/) {
+    if (req.url.compare(0, 5, "/api/") != 0) {
+        return;
+    }
+
+    if (!ipBuckets.tryAcquire(hashKey(req.remote_ip_address), ipLimit, nowMs())) {
+        rejectedCount.fetch_add(1, std::memory_order_relaxed);
+        res.code = 429;
+        res.set_header("Retry-After", "1");
+        res.end("Too many requests.");
+    }
+}
+
+void RateLimiter::after_handle(crow::request& /*req*/, crow::response& /*res*/, context& /*ctx*/) {}
+
+void RateLimiter::setIpLimit(Limit limit) {
+    ipLimit = limit;
+}
+
+uint64_t RateLimiter::rejected() {
+    return rejectedCount.load(std::memory_order_relaxed);
+}
+
+uint64_t RateLimiter::nowMs() const {
+    // offset by one so a stored state is never 0, which marks a full bucket
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count()) + 1;
+}
@@ -0,0 +1,275 @@
+#include "Reconciler.h"
+#include "AsyncLogger.h"
+#include "Journal.h"
+
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    struct Sum {
+        int64_t cents = 0;
+        uint64_t transactions = 0;
+    };
+
+    using Partition = std::unordered_map<int, Sum>;
+
+    std::size_t partitionOf(int accountID, std::size_t partitions) {
+        return static_cast<uint32_t>(accountID) % partitions;
+    }
+
+    /**
+     * @brief Pages handed from the reading thread to the workers. Bounded, so a slow aggregation
+     * holds back the reads instead of piling up pages.
+     */
+    class PageQueue {
+    public:
+        explicit PageQueue(std::size_t capacity) : capacity(capacity) {}
+
+        void push(std::vector<Transaction> page) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notFull.wait(lock, [this] { return pages.size() < capacity; });
+            pages.push_back(std::move(page));
+            notEmpty.notify_one();
+        }
+
+        bool pop(std::vector<Transaction>& page) {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [this] { return !pages.empty() || closed; });
+            if (pages.empty()) {
+                return false;
+            }
+            page = std::move(pages.front());
+            pages.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            notEmpty.notify_all();
+        }
+
+    private:
+        const std::size_t capacity;
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<std::vector<Transaction>> pages;
+        bool closed = false;
+    };
+
+    void writeMoney(std::ostream& out, int64_t cents) {
+        if (cents < 0) {
+            out << '-';
+        }
+        const uint64_t magnitude = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+        const uint64_t fraction = magnitude % 100;
+        out << magnitude / 100 << '.' << (fraction < 10 ? "0" : "") << fraction;
+    }
+}
+
+Reconciler::Report Reconciler::run(const ScanReader& reader, const std::vector<StoredBalance>& balances, std::size_t threads,
+                                   std::size_t pageSize) {
+    const auto started = std::chrono::steady_clock::now();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const std::size_t partitions = threads;
+
+    Report report;
+
+    // Aggregation: every worker sums the pages it takes into its own partitions.
+    std::vector<std::vector<Partition>> sums(threads, std::vector<Partition>(partitions));
+    PageQueue queue(threads * 2);
+    std::vector<std::thread> workers;
+    for (std::size_t worker = 0; worker < threads; worker++) {
+        workers.emplace_back([&queue, &local = sums[worker], partitions] {
+            std::vector<Transaction> page;
+            while (queue.pop(page)) {
+                for (const Transaction& transaction : page) {
+                    const int accountID = transaction.getAccountID();
+                    Sum& sum = local[partitionOf(accountID, partitions)][accountID];
+                    sum.cents += Journal::toCents(transaction.getAmount());
+                    sum.transactions++;
+                }
+            }
+        });
+    }
+
+    std::exception_ptr failure;
+    try {
+        int after = std::numeric_limits<int>::min();
+        for (;;) {
+            std::vector<Transaction> page = reader(after, pageSize);
+            const std::size_t size = page.size();
+            if (size == 0) {
+                break;
+            }
+            after = page.back().getTransactionID();
+            report.transactions += size;
+            report.pages++;
+            queue.push(std::move(page));
+            if (size < pageSize) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "reconciliation.page_failed", { { "pages", static_cast<long long>(report.pages) }, { "error", std::string(e.what()) } });
+        failure = std::current_exception();
+    }
+    queue.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // Diff: worker p merges partition p from every worker and checks the stored balances in it.
+    std::vector<std::vector<const StoredBalance*>> stored(partitions);
+    for (const StoredBalance& balance : balances) {
+        stored[partitionOf(balance.accountID, partitions)].push_back(&balance);
+    }
+
+    std::vector<std::vector<Mismatch>> mismatches(partitions);
+    std::vector<std::size_t> accounts(partitions, 0);
+    workers.clear();
+    for (std::size_t part = 0; part < partitions; part++) {
+        workers.emplace_back([&, part] {
+            Partition merged = std::move(sums[0][part]);
+            for (std::size_t worker = 1; worker < threads; worker++) {
+                for (const auto& entry : sums[worker][part]) {
+                    Sum& sum = merged[entry.first];
+                    sum.cents += entry.second.cents;
+                    sum.transactions += entry.second.transactions;
+                }
+                Partition().swap(sums[worker][part]);
+            }
+
+            std::vector<Mismatch>& found = mismatches[part];
+            for (const StoredBalance* balance : stored[part]) {
+                const int64_t storedCents = Journal::toCents(balance->balance);
+                auto it = merged.find(balance->accountID);
+                const Sum history = it == merged.end() ? Sum{} : it->second;
+                if (it != merged.end()) {
+                    merged.erase(it);
+                }
+                if (storedCents != history.cents) {
+                    found.push_back(Mismatch{ balance->accountID, true, storedCents, history.cents, history.transactions });
+                }
+            }
+            // what is left has transactions but no stored balance
+            for (const auto& entry : merged) {
+                found.push_back(Mismatch{ entry.first, false, 0, entry.second.cents, entry.second.transactions });
+            }
+            accounts[part] = stored[part].size() + merged.size();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (std::size_t part = 0; part < partitions; part++) {
+        report.accounts += accounts[part];
+        report.mismatches.insert(report.mismatches.end(), mismatches[part].begin(), mismatches[part].end());
+    }
+    std::sort(report.mismatches.begin(), report.mismatches.end(),
+              [](const Mismatch& a, const Mismatch& b) { return a.accountID < b.accountID; });
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    report.transactionsPerSecond = report.seconds > 0.0 ? report.transactions / report.seconds : 0.0;
+    AsyncLogger::instance().log(AsyncLogger::Level::Info, "reconciliation.finished", { { "transactions", static_cast<long long>(report.transactions) }, { "accounts", static_cast<long long>(report.accounts) }, { "mismatches", static_cast<long long>(report.mismatches.size()) }, { "seconds", report.seconds } });
+    return report;
+}
+
+void Reconciler::writeCsv(const Report& report, std::ostream& out) {
+    out << "accountID,storedBalance,historyBalance,difference,transactions\n";
+    for (const Mismatch& mismatch : report.mismatches) {
+        out << mismatch.accountID << ',';
+        if (mismatch.stored) {
+            writeMoney(out, mismatch.storedCents);
+        }
+        out << ',';
+        writeMoney(out, mismatch.historyCents);
+        out << ',';
+        writeMoney(out, mismatch.storedCents - mismatch.historyCents);
+        out << ',' << mismatch.transactions << '\n';
+    }
+}
+
+NightlyReconciliation::NightlyReconciliation(Reconciler::ScanReader reader, BalanceReader balances, std::string directory, int hourUtc)
+    : reader(std::move(reader)), balances(std::move(balances)), directory(std::move(directory)), hourUtc(hourUtc), worker([this] { run(); }) {}
+
+NightlyReconciliation::~NightlyReconciliation() {
+    stop();
+}
+
+void NightlyReconciliation::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::chrono::system_clock::time_point NightlyReconciliation::nextRun(std::chrono::system_clock::time_point now, int hourUtc) {
+    using std::chrono::hours;
+    const auto day = std::chrono::duration_cast<hours>(now.time_since_epoch()).count() / 24;
+    std::chrono::system_clock::time_point due{ hours(day * 24 + hourUtc) };
+    if (due <= now) {
+        due += hours(24);
+    }
+    return due;
+}
+
+std::string NightlyReconciliation::runOnce() {
+    const Reconciler::Report report = Reconciler::run(reader, balances());
+
+    const time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    tm utc;
+#ifdef _MSC_VER
+    gmtime_s(&utc, &t);
+#else
+    gmtime_r(&t, &utc);
+#endif
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y-%m-%d", &utc);
+
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path path = std::filesystem::path(directory) / ("reconciliation-" + std::string(date) + ".csv");
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    Reconciler::writeCsv(report, out);
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("cannot write " + path.string());
+    }
+    AsyncLogger::instance().log(AsyncLogger::Level::Info, "reconciliation.report_written", { { "path", path.string() }, { "mismatches", static_cast<long long>(report.mismatches.size()) } });
+    return path.string();
+}
+
+void NightlyReconciliation::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        if (wake.wait_until(lock, nextRun(std::chrono::system_clock::now(), hourUtc), [this] { return stopping; })) {
+            return;
+        }
+        lock.unlock();
+        try {
+            runOnce();
+        } catch (const std::exception& e) {
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "reconciliation.failed", { { "error", std::string(e.what()) } });
+        }
+        lock.lock();
+    }
+}
@@ -10,6 +10,8 @@
 */
 
 #include "SavingsAccount.h"
+#include "Journal.h"
+#include "AccountEvents.h"
 
 using namespace std;
 
@@ -36,9 +38,20 @@ SavingsAccount::SavingsAccount(int accountID, double balance, int userID, string
 *
 * applyInterest():
 * A function that applies interest to the account's balance by increasing the account's balance by its interest, which is calculated by multiplying interest rate and the balance.
+* The interest is posted to the journal like a deposit, and the balance becomes the journal's projection.
+* It is recorded in the account's event stream as a Deposited event.
 */
 void SavingsAccount::applyInterest() {
-    setBalance(getBalance() + getInterest());
+    Journal& journal = Journal::instance();
+    openLedgers();
+    setBalance(journal.balance(getAccountID()));
+    const double interest = getInterest();
+    if (!isValidAmount(interest)) {
+        return; // No interest is posted on an empty or overdrawn balance, or when it rounds to less than a cent
+    }
+    journal.post(Journal::deposit(getAccountID(), interest));
+    setBalance(journal.balance(getAccountID()));
+    AccountEvents::instance().deposited(getAccountID(), interest);
 }
 
 /**
@@ -62,5 +75,5 @@ double SavingsAccount::getInterestRate() {
 * @return interest The account's interest
 */
 double SavingsAccount::getInterest() const {
-    return interestRate * getBalance();
+    return SavingsPolicy::interest(getBalance(), interestRate);
 }
@@ -0,0 +1,235 @@
+#include "StatementGenerator.h"
+#include "AsyncLogger.h"
+#include "Journal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // Accounts a worker claims at once; small enough to keep the workers evenly loaded.
+    constexpr std::size_t kClaimSize = 32;
+
+    const char* const kDefaultTemplate = R"(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>Statement {{month}} - Account {{accountID}}</title>
+<style>
+@page { size: A4; margin: 18mm; }
+body { font-family: Helvetica, Arial, sans-serif; font-size: 10pt; color: #222; }
+table { width: 100%; border-collapse: collapse; }
+thead { display: table-header-group; }
+tr { page-break-inside: avoid; }
+th, td { padding: 3px 6px; border-bottom: 1px solid #ddd; text-align: left; }
+td.money, th.money { text-align: right; font-variant-numeric: tabular-nums; }
+.summary td { border: none; }
+</style>
+</head>
+<body>
+<h1>Account statement</h1>
+<p>Account {{accountID}} &middot; {{month}}</p>
+<table class="summary">
+<tr><td>Opening balance</td><td class="money">{{openingBalance}}</td></tr>
+<tr><td>Money in</td><td class="money">{{totalIn}}</td></tr>
+<tr><td>Money out</td><td class="money">{{totalOut}}</td></tr>
+<tr><td>Closing balance</td><td class="money">{{closingBalance}}</td></tr>
+</table>
+<h2>Transactions ({{transactionCount}})</h2>
+<table>
+<thead><tr><th>Date</th><th>Transaction</th><th>Type</th><th class="money">Amount</th><th class="money">Balance</th></tr></thead>
+<tbody>
+{{#lines}}<tr><td>{{date}}</td><td>{{transactionID}}</td><td>{{type}}</td><td class="money">{{amount}}</td><td class="money">{{balance}}</td></tr>
+{{/lines}}{{^lines}}<tr><td colspan="5">No transactions this month.</td></tr>
+{{/lines}}</tbody>
+</table>
+</body>
+</html>
+)";
+
+    std::string formatMoney(double amount) {
+        char text[32];
+        const int n = snprintf(text, sizeof(text), "%.2f", amount);
+        // "-0.00" from rounding a tiny negative remainder
+        if (n == 5 && text[0] == '-' && text[1] == '0' && text[3] == '0' && text[4] == '0') {
+            return "0.00";
+        }
+        return std::string(text, n);
+    }
+}
+
+StatementGenerator::StatementGenerator() : statementTemplate(crow::mustache::compile(kDefaultTemplate)) {}
+
+StatementGenerator::StatementGenerator(crow::mustache::template_t statementTemplate)
+    : statementTemplate(std::move(statementTemplate)) {}
+
+bool StatementGenerator::validMonth(const std::string& month) {
+    if (month.size() != 7 || month[4] != '-') {
+        return false;
+    }
+    for (int i : { 0, 1, 2, 3, 5, 6 }) {
+        if (month[i] < '0' || month[i] > '9') {
+            return false;
+        }
+    }
+    const int monthNumber = (month[5] - '0') * 10 + (month[6] - '0');
+    return monthNumber >= 1 && monthNumber <= 12;
+}
+
+/**
+ * @brief Dates are YYYY-MM-DD, so comparing the first seven characters places a transaction
+ * before, inside or after the month. Transactions after the month are skipped, not a reason to
+ * stop, since IDs and dates need not be in the same order. For the same reason the month's lines
+ * are collected first and their balances worked out once they are sorted.
+ */
+std::size_t StatementGenerator::render(int accountID, const std::string& month, const PageReader& reader, std::string& out) {
+    struct Line {
+        std::string date;
+        int transactionID;
+        std::string type;
+        int64_t cents;
+    };
+
+    int64_t opening = 0;
+    std::vector<Line> inMonth;
+
+    int cursor = std::numeric_limits<int>::min();
+    for (;;) {
+        const std::vector<Transaction> page = reader(accountID, cursor, kPageSize);
+        for (const auto& transaction : page) {
+            std::string date = transaction.getDate();
+            const int position = date.compare(0, 7, month);
+            if (position > 0) {
+                continue;
+            }
+            const int64_t cents = Journal::toCents(transaction.getAmount());
+            if (position < 0) {
+                opening += cents;
+                continue;
+            }
+            inMonth.push_back(Line{ std::move(date), transaction.getTransactionID(), transaction.getTransactionType(), cents });
+        }
+        if (page.size() < kPageSize) {
+            break;
+        }
+        cursor = page.back().getTransactionID();
+    }
+
+    std::sort(inMonth.begin(), inMonth.end(), [](const Line& a, const Line& b) {
+        const int order = a.date.compare(b.date);
+        return order != 0 ? order < 0 : a.transactionID < b.transactionID;
+    });
+
+    int64_t balance = opening;
+    int64_t totalIn = 0;
+    int64_t totalOut = 0;
+    std::vector<crow::json::wvalue> lines;
+    lines.reserve(inMonth.size());
+    for (const Line& entry : inMonth) {
+        balance += entry.cents;
+        if (entry.cents >= 0) {
+            totalIn += entry.cents;
+        } else {
+            totalOut -= entry.cents;
+        }
+        crow::json::wvalue line;
+        line["transactionID"] = std::to_string(entry.transactionID);
+        line["date"] = entry.date;
+        line["type"] = entry.type;
+        line["amount"] = formatMoney(Journal::fromCents(entry.cents));
+        line["balance"] = formatMoney(Journal::fromCents(balance));
+        lines.push_back(std::move(line));
+    }
+
+    const std::size_t count = lines.size();
+    crow::mustache::context context;
+    context["accountID"] = std::to_string(accountID);
+    context["month"] = month;
+    context["openingBalance"] = formatMoney(Journal::fromCents(opening));
+    context["closingBalance"] = formatMoney(Journal::fromCents(balance));
+    context["totalIn"] = formatMoney(Journal::fromCents(totalIn));
+    context["totalOut"] = formatMoney(Journal::fromCents(totalOut));
+    context["transactionCount"] = std::to_string(count);
+    context["lines"] = std::move(lines);
+    statementTemplate.render(context, out);
+    return count;
+}
+
+StatementGenerator::RunStats StatementGenerator::run(const std::vector<int>& accountIDs, const std::string& month,
+                                                     const PageReader& reader, const Sink& sink, std::size_t threads) {
+    if (!validMonth(month)) {
+        throw std::invalid_argument("statement month must be YYYY-MM");
+    }
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, std::max<std::size_t>(1, accountIDs.size()));
+
+    const auto started = std::chrono::steady_clock::now();
+    std::atomic<std::size_t> next{ 0 };
+    std::mutex statsMutex;
+    RunStats stats;
+
+    auto work = [&] {
+        RunStats local;
+        std::string document;
+        for (;;) {
+            const std::size_t begin = next.fetch_add(kClaimSize, std::memory_order_relaxed);
+            if (begin >= accountIDs.size()) {
+                break;
+            }
+            const std::size_t end = std::min(begin + kClaimSize, accountIDs.size());
+            for (std::size_t i = begin; i < end; i++) {
+                const int accountID = accountIDs[i];
+                document.clear();
+                try {
+                    const std::size_t lines = render(accountID, month, reader, document);
+                    sink(accountID, document);
+                    local.statements++;
+                    local.transactions += lines;
+                    local.bytes += document.size();
+                } catch (const std::exception& e) {
+                    AsyncLogger::instance().log(AsyncLogger::Level::Error, "statement.failed", { { "accountID", accountID }, { "month", month }, { "what", e.what() } });
+                    local.failed++;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.statements += local.statements;
+        stats.failed += local.failed;
+        stats.transactions += local.transactions;
+        stats.bytes += local.bytes;
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    AsyncLogger::instance().log(AsyncLogger::Level::Info, "statement.run_finished", { { "month", month }, { "statements", static_cast<long long>(stats.statements) }, { "failed", static_cast<long long>(stats.failed) }, { "seconds", stats.seconds } });
+    return stats;
+}
+
+StatementGenerator::Sink StatementGenerator::directorySink(const std::string& directory, const std::string& month) {
+    return [directory, month](int accountID, const std::string& document) {
+        const std::string path = directory + "/" + std::to_string(accountID) + "-" + month + ".html";
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(document.data(), static_cast<std::streamsize>(document.size()));
+        if (!file) {
+            throw std::runtime_error("cannot write " + path);
+        }
+    };
+}
@@ -1,10 +1,90 @@
 #include "Transaction.h"
 #include "firebaseConfig.h"
+#include "ModelJson.h"
+#include "AsyncLogger.h"
+#include "BalanceCheckpoints.h"
+#include "TransactionFeed.h"
+#include "AccountChangeLog.h"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <limits>
 #include <vector>
 #include <thread>
 #include <chrono>
+#include <stdexcept>
+
+namespace {
+    // balanceAfter of a row written before balances were stored with transactions, until it is filled
+    constexpr double kNoBalance = std::numeric_limits<double>::quiet_NaN();
+
+    double storedBalance(const firebase::firestore::FieldValue& balanceAfter) {
+        return balanceAfter.is_double() ? balanceAfter.double_value() : kNoBalance;
+    }
+
+    /**
+     * @brief Blocks until a Firestore call has completed.
+     */
+    template <typename T>
+    void await(const firebase::Future<T>& future) {
+        while (future.status() == firebase::kFutureStatusPending) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    /**
+     * @brief Reads the page of a transactions query after `afterTransactionID`, in transaction ID order.
+     * 
+     * @param complete Cleared when a row was written before balances were stored with transactions.
+     * @throws std::runtime_error With Firestore's message, if the query fails.
+     */
+    std::vector<Transaction> readPage(const firebase::firestore::Query& transactions, int afterTransactionID, std::size_t limit, bool& complete) {
+        auto future = transactions.OrderBy("transactionID")
+                          .StartAfter(std::vector<firebase::firestore::FieldValue>{ firebase::firestore::FieldValue::Integer(afterTransactionID) })
+                          .Limit(static_cast<int32_t>(limit))
+                          .Get();
+        await(future);
+        if (future.error() != firebase::firestore::Error::kErrorOk) {
+            throw std::runtime_error(future.error_message());
+        }
+
+        std::vector<Transaction> page;
+        page.reserve(limit);
+        for (const auto& doc : future.result()->documents()) {
+            if (doc.exists()) {
+                const double balanceAfter = storedBalance(doc.Get("balanceAfter"));
+                complete = complete && !std::isnan(balanceAfter);
+                page.emplace_back(static_cast<int>(doc.Get("transactionID").integer_value()),
+                                  static_cast<int>(doc.Get("accountID").integer_value()),
+                                  doc.Get("transactionType").string_value(), doc.Get("amount").double_value(),
+                                  doc.Get("date").string_value(), balanceAfter);
+            }
+        }
+        return page;
+    }
+
+    /**
+     * @brief Reads the highest transaction ID stored in Firestore, 0 if there are none.
+     * @throws std::runtime_error With Firestore's message, if the query fails.
+     */
+    int readHighestTransactionID() {
+        auto db = firebaseConfig::getFirestoreInstance();
+        auto future = db->Collection("transactions").OrderBy("transactionID", firebase::firestore::Query::Direction::kDescending).Limit(1).Get();
+        await(future);
+        if (future.error() != firebase::firestore::Error::kErrorOk) {
+            throw std::runtime_error(future.error_message());
+        }
+        for (const auto& doc : future.result()->documents()) {
+            if (doc.exists()) {
+                return static_cast<int>(doc.Get("transactionID").integer_value());
+            }
+        }
+        return 0;
+    }
+}
+
 /**
  * @brief Constructs a Transaction object.
  * 
@@ -13,9 +93,11 @@
  * @param transactionType The type of the transaction (e.g., "deposit", "withdrawal").
  * @param amount The amount involved in the transaction.
  * @param date The date of the transaction in YYYY-MM-DD format.
+ * @param balanceAfter The account balance once the transaction was committed; left out, it is NaN
+ *                     (unknown), so hasBalanceAfter() is false and the row is not saved with a 0 balance.
  */
-Transaction::Transaction(int transactionID, int accountID, const std::string& transactionType, double amount, const std::string& date)
-    : transactionID(transactionID), accountID(accountID), transactionType(transactionType), amount(amount), date(date) {}
+Transaction::Transaction(int transactionID, int accountID, const std::string& transactionType, double amount, const std::string& date, double balanceAfter)
+    : transactionID(transactionID), accountID(accountID), transactionType(transactionType), amount(amount), date(date), balanceAfter(balanceAfter) {}
 
 /**
  * @brief Gets the unique ID of the transaction.
@@ -62,6 +144,75 @@ std::string Transaction::getDate() const {
     return date;
 }
 
+/**
+ * @brief Gets the account balance once the transaction was committed.
+ * 
+ * @return The running balance after the transaction.
+ */
+double Transaction::getBalanceAfter() const {
+    return balanceAfter;
+}
+
+/**
+ * @brief Checks whether the transaction carries its running balance.
+ * 
+ * @return False for a row stored before balances were kept with transactions, until it is filled.
+ */
+bool Transaction::hasBalanceAfter() const {
+    return !std::isnan(balanceAfter);
+}
+
+/**
+ * @brief Sets the running balance after the transaction; done once, when it is committed.
+ * 
+ * @param newBalanceAfter The account balance after the transaction.
+ */
+void Transaction::setBalanceAfter(double newBalanceAfter) {
+    balanceAfter = newBalanceAfter;
+}
+
+/**
+ * @brief Serializes the transaction as a JSON object.
+ * 
+ * @return The transaction as a JSON string.
+ */
+std::string Transaction::toJson() const {
+    return toJsonString(*this);
+}
+
+/**
+ * @brief Writes the transaction to Firestore, balance included, as document `transactions/<transactionID>`.
+ * 
+ * @return True if the write was acknowledged, false otherwise.
+ */
+bool Transaction::saveToDatabase() const {
+    try {
+        auto db = firebaseConfig::getFirestoreInstance();
+        firebase::firestore::MapFieldValue fields{
+            { "transactionID", firebase::firestore::FieldValue::Integer(transactionID) },
+            { "accountID", firebase::firestore::FieldValue::Integer(accountID) },
+            { "transactionType", firebase::firestore::FieldValue::String(transactionType) },
+            { "amount", firebase::firestore::FieldValue::Double(amount) },
+            { "date", firebase::firestore::FieldValue::String(date) },
+        };
+        if (hasBalanceAfter()) {
+            fields["balanceAfter"] = firebase::firestore::FieldValue::Double(balanceAfter);
+        }
+
+        auto future = db->Collection("transactions").Document(std::to_string(transactionID)).Set(fields);
+        await(future);
+
+        if (future.error() != firebase::firestore::Error::kErrorOk) {
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.save_failed", { { "transactionID", transactionID }, { "accountID", accountID }, { "error", future.error_message() } });
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.save_exception", { { "transactionID", transactionID }, { "what", e.what() } });
+        return false;
+    }
+}
+
 /**
  * @brief Fetches a list of transactions for a specific account from Firestore.
  * 
@@ -70,6 +221,7 @@ std::string Transaction::getDate() const {
  */
 std::vector<Transaction> Transaction::getTransactions(int accountID) {
     std::vector<Transaction> transactions;
+    bool missingBalances = false;
 
     try {
         // Reference to the Firestore collection
@@ -83,9 +235,7 @@ std::vector<Transaction> Transaction::getTransactions(int accountID) {
         auto future = query.Get();
 
         // Wait for the query to complete
-        while (future.status() == firebase::kFutureStatusPending) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+        await(future);
 
         if (future.error() == firebase::firestore::Error::kErrorOk) {
             // Process the query results
@@ -97,17 +247,146 @@ std::vector<Transaction> Transaction::getTransactions(int accountID) {
                     std::string transactionType = doc.Get("transactionType").string_value();
                     double amount = doc.Get("amount").double_value();
                     std::string date = doc.Get("date").string_value();
+                    const double balanceAfter = storedBalance(doc.Get("balanceAfter"));
+                    missingBalances = missingBalances || std::isnan(balanceAfter);
 
                     // Create a Transaction object and add it to the vector
-                    transactions.emplace_back(transactionID, accountID, transactionType, amount, date);
+                    transactions.emplace_back(transactionID, accountID, transactionType, amount, date, balanceAfter);
+                }
+            }
+
+            // Rows written before balances were stored: with the whole history at hand, one pass fills
+            // them, restarting the running sum from every row that has its balance
+            if (missingBalances) {
+                std::sort(transactions.begin(), transactions.end(), [](const Transaction& a, const Transaction& b) {
+                    return a.getTransactionID() < b.getTransactionID();
+                });
+                double balance = 0.0;
+                for (auto& transaction : transactions) {
+                    if (transaction.hasBalanceAfter()) {
+                        balance = transaction.getBalanceAfter();
+                    } else {
+                        balance += transaction.getAmount();
+                        transaction.setBalanceAfter(balance);
+                    }
                 }
             }
         } else {
-            std::cerr << "Error fetching transactions from Firestore: " << future.error_message() << std::endl;
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.fetch_failed", { { "accountID", accountID }, { "error", future.error_message() } });
         }
     } catch (const std::exception& e) {
-        std::cerr << "Exception while fetching transactions: " << e.what() << std::endl;
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.fetch_exception", { { "accountID", accountID }, { "what", e.what() } });
+    }
+
+    return transactions;
+}
+
+/**
+ * @brief Reads one page of an account's transactions as stored, ordered by transaction ID.
+ * 
+ * @param complete Cleared when a row was written before balances were stored with transactions.
+ * @throws std::runtime_error If the query fails.
+ */
+static std::vector<Transaction> readTransactionsPage(int accountID, int afterTransactionID, std::size_t limit, bool& complete) {
+    auto db = firebaseConfig::getFirestoreInstance();
+    try {
+        return readPage(db->Collection("transactions").WhereEqualTo("accountID", firebase::firestore::FieldValue::Integer(accountID)),
+                        afterTransactionID, limit, complete);
+    } catch (const std::runtime_error& e) {
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.page_failed", { { "accountID", accountID }, { "after", afterTransactionID }, { "error", e.what() } });
+        throw;
     }
+}
 
+/**
+ * @brief Fetches one page of an account's transactions from Firestore, ordered by transaction ID.
+ * 
+ * Unlike getTransactions(), a failed query throws, so a caller walking the history page by page
+ * never mistakes a partial history for a complete one. Every row has its balance after the
+ * transaction: stored rows carry it, and older rows get it from the nearest balance checkpoint.
+ * 
+ * @param accountID The ID of the account for which transactions are fetched.
+ * @param afterTransactionID Only transactions with a higher ID are returned.
+ * @param limit The largest number of transactions to return.
+ * @return Up to `limit` transactions in ID order; fewer means the history has ended.
+ */
+std::vector<Transaction> Transaction::getTransactionsPage(int accountID, int afterTransactionID, std::size_t limit) {
+    bool complete = true;
+    std::vector<Transaction> transactions = readTransactionsPage(accountID, afterTransactionID, limit, complete);
+    if (!complete) {
+        BalanceCheckpoints::instance().fill(accountID, afterTransactionID, transactions, [](int id, int after, std::size_t count) {
+            bool ignored = true;
+            return readTransactionsPage(id, after, count, ignored);
+        });
+    }
     return transactions;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Fetches one page of every account's transactions from Firestore, ordered by transaction ID.
+ * 
+ * Used by jobs that walk the whole transaction set once, such as reconciliation. Rows are returned
+ * as stored; missing balances are not filled in. A failed query throws.
+ * 
+ * @param afterTransactionID Only transactions with a higher ID are returned.
+ * @param limit The largest number of transactions to return.
+ * @return Up to `limit` transactions in ID order; fewer means the set has ended.
+ */
+std::vector<Transaction> Transaction::getAllTransactionsPage(int afterTransactionID, std::size_t limit) {
+    auto db = firebaseConfig::getFirestoreInstance();
+    bool ignored = true;
+    try {
+        return readPage(db->Collection("transactions"), afterTransactionID, limit, ignored);
+    } catch (const std::runtime_error& e) {
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "transactions.scan_failed", { { "after", afterTransactionID }, { "error", e.what() } });
+        throw;
+    }
+}
+
+/**
+ * @brief Saves a newly committed transaction and hands it to everything that follows new ones.
+ * 
+ * A saved transaction also becomes a balance checkpoint. The transaction feed and the account's
+ * change log get it either way, since the money has moved whether or not the record was stored.
+ * 
+ * @return True if the write was acknowledged, false otherwise.
+ */
+bool Transaction::publish() const {
+    const bool saved = saveToDatabase();
+    if (saved) {
+        BalanceCheckpoints::instance().record(*this);
+    }
+    TransactionFeed::instance().append(*this);
+    AccountChangeLog::instance().recordTransaction(*this);
+    return saved;
+}
+
+/**
+ * @brief Hands out the ID for a new transaction.
+ * 
+ * The first call reads the highest ID stored in Firestore, so IDs keep rising across restarts;
+ * after that IDs come from an in-memory counter. If that read fails it throws, and the next call
+ * tries again.
+ * 
+ * @return An ID no stored or previously returned transaction has.
+ */
+int Transaction::nextTransactionID() {
+    static std::atomic<int> last{ readHighestTransactionID() };
+    return ++last;
+}
+
+/**
+ * @brief Returns today's date in UTC, in the YYYY-MM-DD format of `date`.
+ */
+std::string Transaction::today() {
+    const time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    tm utc;
+#ifdef _MSC_VER
+    gmtime_s(&utc, &t);
+#else
+    gmtime_r(&t, &utc);
+#endif
+    char date[16];
+    std::strftime(date, sizeof(date), "%Y-%m-%d", &utc);
+    return date;
+}
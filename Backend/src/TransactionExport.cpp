@@ -0,0 +1,148 @@
+#include "TransactionExport.h"
+#include "ModelJson.h"
+#include "AsyncLogger.h"
+
+#include <charconv>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+    // Shared by the stream and the page read in flight, which may finish after the client has gone.
+    struct ExportState {
+        std::mutex mutex;
+        std::vector<Transaction> ready;   // the page read ahead, guarded by mutex
+        bool readyValid = false;
+        bool fetching = false;
+        bool failed = false;
+        bool lastPage = false;
+        int cursor = std::numeric_limits<int>::min(); // ID of the last transaction read
+        crow::stream_waker waker;         // set while the stream waits for a page
+        bool headerWritten = false;       // only touched by the stream
+    };
+
+    void appendCsvField(std::string& out, const std::string& text) {
+        if (text.find_first_of(",\"\r\n") == std::string::npos) {
+            out += text;
+            return;
+        }
+        out += '"';
+        for (char c : text) {
+            if (c == '"') {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    template <typename Number>
+    void appendNumber(std::string& out, Number number) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        out.append(digits, result.ptr);
+    }
+
+    // Starts reading the page after state->cursor; the caller holds state->mutex.
+    void fetchNext(const std::shared_ptr<ExportState>& state, int accountID, const TransactionExport::PageReader& reader,
+                   PriorityScheduler& scheduler, std::size_t pageSize) {
+        state->fetching = true;
+        const int after = state->cursor;
+        scheduler.submit(PriorityScheduler::Priority::History, [state, accountID, reader, pageSize, after] {
+            std::vector<Transaction> page;
+            bool failed = false;
+            try {
+                page = reader(accountID, after, pageSize);
+            } catch (const std::exception& e) {
+                AsyncLogger::instance().log(AsyncLogger::Level::Error, "export.page_failed", { { "accountID", accountID }, { "after", after }, { "what", e.what() } });
+                failed = true;
+            }
+
+            crow::stream_waker waker;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->fetching = false;
+                state->failed = failed;
+                state->lastPage = failed || page.size() < pageSize;
+                if (!page.empty()) {
+                    state->cursor = page.back().getTransactionID();
+                }
+                state->ready = std::move(page);
+                state->readyValid = true;
+                waker = state->waker;
+                state->waker = crow::stream_waker();
+            }
+            waker();
+        });
+    }
+}
+
+std::function<bool(std::string&, const crow::stream_waker&)> TransactionExport::source(
+    int accountID, Format format, PageReader reader, PriorityScheduler& scheduler, std::size_t pageSize) {
+    auto state = std::make_shared<ExportState>();
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        fetchNext(state, accountID, reader, scheduler, pageSize);
+    }
+
+    return [state, accountID, format, reader = std::move(reader), &scheduler, pageSize](std::string& chunk, const crow::stream_waker& waker) {
+        if (!state->headerWritten) {
+            state->headerWritten = true;
+            if (format == Format::Csv) {
+                chunk += "transactionID,accountID,transactionType,amount,date,balanceAfter\r\n";
+            }
+        }
+
+        std::vector<Transaction> page;
+        bool lastPage;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->readyValid) {
+                // the page is still being read; its completion wakes the stream
+                state->waker = waker;
+                return true;
+            }
+            if (state->failed) {
+                throw std::runtime_error("transaction export: reading a page failed");
+            }
+            page.swap(state->ready);
+            state->readyValid = false;
+            lastPage = state->lastPage;
+            if (!lastPage) {
+                // read the next page while this one is written
+                fetchNext(state, accountID, reader, scheduler, pageSize);
+            }
+        }
+
+        for (const auto& transaction : page) {
+            if (format == Format::Csv) {
+                appendCsvRow(chunk, transaction);
+            } else {
+                appendNdjsonRow(chunk, transaction);
+            }
+        }
+        return !lastPage;
+    };
+}
+
+void TransactionExport::appendCsvRow(std::string& out, const Transaction& transaction) {
+    appendNumber(out, transaction.getTransactionID());
+    out += ',';
+    appendNumber(out, transaction.getAccountID());
+    out += ',';
+    appendCsvField(out, transaction.getTransactionType());
+    out += ',';
+    appendNumber(out, transaction.getAmount());
+    out += ',';
+    appendCsvField(out, transaction.getDate());
+    out += ',';
+    appendNumber(out, transaction.getBalanceAfter());
+    out += "\r\n";
+}
+
+void TransactionExport::appendNdjsonRow(std::string& out, const Transaction& transaction) {
+    JsonWriter writer(out);
+    writeJson(writer, transaction);
+    out += '\n';
+}
@@ -0,0 +1,209 @@
+#include "TransactionFeed.h"
+
+#include "crow_all.h"
+
+#include <chrono>
+#include <iterator>
+
+namespace {
+    constexpr auto kHeartbeat = std::chrono::seconds(15);
+    constexpr std::size_t kChunkBytes = 16 * 1024;
+
+    void appendNumber(std::string& out, uint64_t value) {
+        char digits[24];
+        const int n = snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(value));
+        out.append(digits, n);
+    }
+}
+
+TransactionFeed& TransactionFeed::instance() {
+    static TransactionFeed feed;
+    return feed;
+}
+
+TransactionFeed::TransactionFeed() : heartbeat([this] { run(); }) {}
+
+TransactionFeed::~TransactionFeed() {
+    stop();
+}
+
+void TransactionFeed::stop() {
+    {
+        std::lock_guard<std::mutex> lock(heartbeatMutex);
+        stopping = true;
+    }
+    heartbeatWake.notify_all();
+    if (heartbeat.joinable()) {
+        heartbeat.join();
+    }
+}
+
+/**
+ * @brief Encodes the transaction as an event once; every stream of the account shares the text.
+ */
+uint64_t TransactionFeed::append(const Transaction& transaction) {
+    const int accountID = transaction.getAccountID();
+    Tail* existing = tails.find(accountID);
+    Tail& tail = existing ? *existing : tails.get(accountID);
+    std::vector<std::function<void()>> waiters;
+    uint64_t sequence;
+    {
+        std::lock_guard<std::mutex> lock(tail.mutex);
+        sequence = ++tail.head;
+
+        auto text = std::make_shared<std::string>("id: ");
+        appendNumber(*text, sequence);
+        *text += "\nevent: transaction\ndata: ";
+        *text += transaction.toJson();
+        *text += "\n\n";
+
+        tail.events.push_back(Event{ sequence, std::move(text) });
+        if (tail.events.size() > kTailCapacity) {
+            tail.events.pop_front();
+        }
+        waiters.swap(tail.waiters);
+    }
+    if (!existing) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        auto it = idle.find(accountID);
+        if (it != idle.end()) {
+            waiters.insert(waiters.end(), std::make_move_iterator(it->second.begin()), std::make_move_iterator(it->second.end()));
+            idle.erase(it);
+        }
+    }
+    for (auto& wake : waiters) {
+        wake();
+    }
+    return sequence;
+}
+
+TransactionFeed::ReadStatus TransactionFeed::read(int accountID, uint64_t& cursor, std::string& out, std::size_t maxBytes) {
+    Tail* found = tails.find(accountID);
+    if (!found) {
+        // no events yet: answered as an empty tail at sequence 0
+        if (cursor == 0) {
+            return ReadStatus::Empty;
+        }
+        cursor = 0;
+        return ReadStatus::Gap;
+    }
+    Tail& tail = *found;
+    std::lock_guard<std::mutex> lock(tail.mutex);
+    if (cursor == tail.head) {
+        return ReadStatus::Empty;
+    }
+    // sequences in the tail are consecutive, so the cursor's position is a subtraction
+    const uint64_t oldest = tail.events.empty() ? tail.head + 1 : tail.events.front().sequence;
+    if (cursor > tail.head || cursor + 1 < oldest) {
+        cursor = tail.head;
+        return ReadStatus::Gap;
+    }
+    for (std::size_t i = static_cast<std::size_t>(cursor + 1 - oldest); i < tail.events.size() && out.size() < maxBytes; i++) {
+        out += *tail.events[i].text;
+        cursor = tail.events[i].sequence;
+    }
+    return ReadStatus::Events;
+}
+
+uint64_t TransactionFeed::head(int accountID) {
+    Tail* tail = tails.find(accountID);
+    if (!tail) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(tail->mutex);
+    return tail->head;
+}
+
+void TransactionFeed::wait(int accountID, uint64_t cursor, std::function<void()> wake) {
+    Tail* tail = tails.find(accountID);
+    if (!tail) {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        // append() creates the tail before it takes this lock, so looking again here cannot miss it
+        tail = tails.find(accountID);
+        if (!tail && cursor == 0) {
+            idle[accountID].push_back(std::move(wake));
+            return;
+        }
+    }
+    if (tail) {
+        std::lock_guard<std::mutex> lock(tail->mutex);
+        if (cursor == tail->head) {
+            tail->waiters.push_back(std::move(wake));
+            return;
+        }
+    }
+    // something arrived between the read and this call
+    wake();
+}
+
+/**
+ * @brief The stream first sends everything after the cursor, then waits on the tail; a wake-up
+ * with nothing new is the heartbeat and sends an SSE comment, which also finds dead clients.
+ */
+std::function<bool(std::string&, const crow::stream_waker&)> TransactionFeed::eventSource(int accountID, uint64_t cursor) {
+    struct State {
+        int accountID;
+        uint64_t cursor;
+        bool started = false;
+        bool waited = false;
+    };
+    auto state = std::make_shared<State>(State{ accountID, cursor });
+
+    return [this, state](std::string& chunk, const crow::stream_waker& waker) {
+        if (!state->started) {
+            state->started = true;
+            chunk += "retry: 2000\n\n";
+        }
+
+        const ReadStatus status = read(state->accountID, state->cursor, chunk, kChunkBytes);
+        if (status == ReadStatus::Gap) {
+            chunk += "id: ";
+            appendNumber(chunk, state->cursor);
+            chunk += "\nevent: reset\ndata: {\"head\":";
+            appendNumber(chunk, state->cursor);
+            chunk += "}\n\n";
+        } else if (status == ReadStatus::Empty && chunk.empty()) {
+            if (state->waited) {
+                state->waited = false;
+                chunk += ": keepalive\n\n";
+                return true;
+            }
+            state->waited = true;
+            wait(state->accountID, state->cursor, waker);
+            return true;
+        }
+        state->waited = false;
+        return true;
+    };
+}
+
+void TransactionFeed::run() {
+    std::unique_lock<std::mutex> lock(heartbeatMutex);
+    while (!heartbeatWake.wait_for(lock, kHeartbeat, [this] { return stopping; })) {
+        lock.unlock();
+        std::vector<std::function<void()>> waiters;
+        for (auto& shard : tails) {
+            std::lock_guard<std::mutex> shardLock(shard.mutex);
+            for (auto& entry : shard.entries) {
+                std::lock_guard<std::mutex> tailLock(entry.second.mutex);
+                for (auto& wake : entry.second.waiters) {
+                    waiters.push_back(std::move(wake));
+                }
+                entry.second.waiters.clear();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> idleLock(idleMutex);
+            for (auto& entry : idle) {
+                for (auto& wake : entry.second) {
+                    waiters.push_back(std::move(wake));
+                }
+            }
+            idle.clear();
+        }
+        for (auto& wake : waiters) {
+            wake();
+        }
+        lock.lock();
+    }
+}
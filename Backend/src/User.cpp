@@ -1,5 +1,6 @@
 #include "User.h"
-#include <iostream>
+#include "ModelJson.h"
+#include "AsyncLogger.h"
 #include <thread>
 //#include <firebase/database.h>
 
@@ -34,6 +35,14 @@ void User::setCardNum(const string& newCardNum) {
     cardNum = newCardNum;
 }
 
+/**
+ * @brief Serializes the user as a JSON object.
+ * @returns The user's ID and username as a JSON string.
+ */
+string User::toJson() const {
+    return toJsonString(*this);
+}
+
 void User::saveUser() {
     /* auto user_ref = database->GetReference("users").Child(std::to_string(userID));
     user_ref.Child("username").SetValue(username.c_str());
@@ -62,13 +71,13 @@ bool User::loadFromDatabase(firebase::database::Database* database) {
                 cardNum = snapshot.Child("cardNum").value().string_value();
                 return true;
             } else {
-                cerr << "User data not found in the database." << endl;
+                AsyncLogger::instance().log(AsyncLogger::Level::Warning, "user.not_found", { { "userID", userID } });
             }
         } else {
-            cerr << "Error loading user data: " << future.error_message() << endl;
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "user.load_failed", { { "userID", userID }, { "error", future.error_message() } });
         }
     } catch (const exception& e) {
-        cerr << "Exception while loading user data: " << e.what() << endl;
+        AsyncLogger::instance().log(AsyncLogger::Level::Error, "user.load_exception", { { "userID", userID }, { "what", e.what() } });
     }
 
     return false;
@@ -84,7 +93,7 @@ void User::fetchUser(firebase::database::Database* database, int userID, const f
             User user(userID, username, cardNum);
             callback(user);
         } else {
-            std::cerr << "Error fetching user data: " << result.error_message() << std::endl;
+            AsyncLogger::instance().log(AsyncLogger::Level::Error, "user.fetch_failed", { { "userID", userID }, { "error", result.error_message() } });
         }
     });
 }
\ No newline at end of file
@@ -17,14 +17,39 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
+#include <cmath>
+#include <cctype>
+#include <cerrno>
+#include <climits>
 #include "User.h"
 #include "Account.h"
 #include "Transaction.h"
 #include "SavingsAccount.h"
 #include "CheckingsAccount.h"
+#include "RateLimiter.h"
+#include "AdmissionControl.h"
+#include "PriorityScheduler.h"
+#include "JsonIndex.h"
+#include "ModelJson.h"
+#include "AsyncLogHandler.h"
+#include "BalanceFeed.h"
+#include "TransactionFeed.h"
+#include "AccountChangeLog.h"
+#include "BalanceCheckpoints.h"
+#include "HoldLedger.h"
+#include "Journal.h"
+#include "AccountEvents.h"
+#include "TransactionExport.h"
+#include "Reconciler.h"
+#include "StatementGenerator.h"
 
 using namespace std;
 
+// Crow application type with the middlewares used by every route; the rate limiter and
+// admission control run first so rejected requests never reach the others
+using BankingApp = crow::App<RateLimiter, AdmissionControl>;
+
 // Firebase instances
 firebase::database::Database* database;
 firebase::auth::Auth* auth;
@@ -91,101 +116,515 @@ bool isUserLockedOut(const string& userId) {
     return false;
 }
 
+// Content-Type line for JSON responses, encoded once and sent as is.
+static const crow::header_block jsonHeaders{ { "Content-Type", "application/json" } };
+
+// Headers for server-sent event streams.
+static const crow::header_block eventStreamHeaders{ { "Content-Type", "text/event-stream" }, { "Cache-Control", "no-cache" } };
+
+// Content-Type line for rendered statements.
+static const crow::header_block htmlHeaders{ { "Content-Type", "text/html; charset=utf-8" } };
+
+// Headers for transaction history exports.
+static const crow::header_block csvExportHeaders{ { "Content-Type", "text/csv; charset=utf-8" }, { "Content-Disposition", "attachment; filename=\"transactions.csv\"" } };
+static const crow::header_block ndjsonExportHeaders{ { "Content-Type", "application/x-ndjson" }, { "Content-Disposition", "attachment; filename=\"transactions.ndjson\"" } };
+
+/**
+ * @brief Builds a response from an already serialized JSON body.
+ * @param body The JSON text.
+ * @returns A response with the JSON content type set.
+ */
+crow::response jsonResponse(std::string body) {
+    crow::response res(std::move(body));
+    res.add_header_block(jsonHeaders);
+    return res;
+}
+
+/**
+ * @brief Builds a JSON response whose body is written in the request's arena.
+ * @details The body stays in the arena until the connection has written it, so it is neither
+ * grown on the heap nor copied into the response. Requests without an arena get the body in
+ * the response as usual.
+ * @param arena The request's arena, or nullptr.
+ * @param code The status code.
+ * @param write Called with a JsonWriter or an ArenaJsonWriter to write the body.
+ * @returns A response with the JSON content type set.
+ */
+template <typename Write>
+crow::response arenaJsonResponse(crow::request_arena* arena, int code, Write write) {
+    crow::response res(code);
+    res.add_header_block(jsonHeaders);
+    if (!arena) {
+        JsonWriter writer(res.body);
+        write(writer);
+        return res;
+    }
+    std::pmr::string& out = arena->make_string();
+    out.reserve(256);
+    ArenaJsonWriter writer(out);
+    write(writer);
+    res.set_body_view(out);
+    return res;
+}
+
+/**
+ * @brief Writes an account's ledger and available balances as JSON.
+ * @param writer The writer to append to.
+ * @param accountId The account.
+ * @param balances The balances from the hold ledger.
+ */
+template <typename Writer>
+void writeBalances(Writer& writer, int accountId, const HoldLedger::Balances& balances) {
+    writer.beginObject();
+    writer.key("accountID");
+    writer.value(accountId);
+    writer.key("balance");
+    writer.value(balances.ledger);
+    writer.key("held");
+    writer.value(balances.held);
+    writer.key("available");
+    writer.value(balances.available);
+    writer.key("pendingHolds");
+    writer.value(static_cast<int64_t>(balances.holds));
+    writer.endObject();
+}
+
+/**
+ * @brief Makes sure the hold ledger knows an account's balance, seeding it from the account's event stream.
+ * @param accountId The account.
+ * @returns False if the account has never been opened, true otherwise.
+ */
+bool seedHoldBalance(int accountId) {
+    auto& holds = HoldLedger::instance();
+    if (holds.balances(accountId).known) {
+        return true;
+    }
+    AccountEvents::State state;
+    if (!AccountEvents::instance().find(accountId, state)) {
+        return false;
+    }
+    holds.seedBalance(accountId, Journal::fromCents(state.balanceCents));
+    return true;
+}
+
+/**
+ * @brief Reads an account ID sent as a string in a request body.
+ * @param text The ID, digits only.
+ * @param accountId Receives the ID.
+ * @returns False if the text is empty, has anything but digits, or does not fit in an int.
+ */
+bool parseAccountId(const string& text, int& accountId) {
+    char* end = nullptr;
+    errno = 0;
+    const long parsed = strtol(text.c_str(), &end, 10);
+    if (text.empty() || !isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' || errno == ERANGE || parsed > INT_MAX) {
+        return false;
+    }
+    accountId = static_cast<int>(parsed);
+    return true;
+}
+
+/**
+ * @brief Reads a frontend file straight into a response body.
+ * @param path The path of the file relative to the Frontend directory.
+ * @param contents Receives the file contents.
+ * @returns True if the file could be opened, false otherwise.
+ */
+bool readFrontendFile(const string& path, std::string& contents) {
+    std::ifstream file("../Frontend/" + path, std::ios::binary | std::ios::ate);
+    if (!file || file.tellg() < 0) {
+        return false;
+    }
+
+    contents.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(contents.data(), contents.size());
+    return true;
+}
+
 /**
  * @brief Links API routes for the backend.
  * @details This function defines API endpoints for user data, account data, and transactions.
- * It also serves static files for the React frontend.
+ * It also serves static files for the React frontend. Every handler runs on the priority
+ * scheduler, so transfers keep their share of the workers when static traffic spikes; a route's
+ * priority comes from the scheduler's route table.
  * @param app The Crow application instance.
+ * @param scheduler The pool the handlers run on.
  */
-void linkRoutes(crow::SimpleApp& app) {
+void linkRoutes(BankingApp& app, PriorityScheduler& scheduler) {
     // Endpoint to get user data
     CROW_ROUTE(app, "/api/user/<string>")
-    ([](const string& userId) {
-        if (isUserLockedOut(userId)) {
-            return crow::response(403, "User is locked out.");
-        }
+    ([&scheduler](const crow::request& req, crow::response& res, string userId) {
+        scheduler.dispatch(req, res, [userId] {
+            if (isUserLockedOut(userId)) {
+                return crow::response(403, "User is locked out.");
+            }
 
-        User user(userId);
-        if (!user.loadFromDatabase(database)) {
-            return crow::response(404, "User not found.");
-        }
+            User user(userId);
+            if (!user.loadFromDatabase(database)) {
+                return crow::response(404, "User not found.");
+            }
 
-        return crow::response(user.toJson());
+            return jsonResponse(user.toJson());
+        });
     });
 
     // Endpoint to get account data
     CROW_ROUTE(app, "/api/account/<string>")
-    ([](const string& accountId) {
-        Account account(accountId);
-        if (!account.loadFromDatabase(database)) {
-            return crow::response(404, "Account not found.");
+    ([&scheduler](const crow::request& req, crow::response& res, string accountId) {
+        scheduler.dispatch(req, res, [accountId] {
+            Account account(accountId);
+            if (!account.loadFromDatabase(database)) {
+                return crow::response(404, "Account not found.");
+            }
+
+            return jsonResponse(account.toJson());
+        });
+    });
+
+    // Endpoint to get an account's transaction history, streamed as a chunked JSON array
+    CROW_ROUTE(app, "/api/transactions/<int>")
+    ([&scheduler](const crow::request& req, crow::response& res, int accountId) {
+        scheduler.dispatch(req, res, [accountId] {
+            auto transactions = std::make_shared<vector<Transaction>>(Transaction::getTransactions(accountId));
+            size_t next = 0;
+            crow::response streamed;
+            streamed.add_header_block(jsonHeaders);
+            streamed.stream(streamJsonArray([transactions, next]() mutable -> const Transaction* {
+                return next < transactions->size() ? &(*transactions)[next++] : nullptr;
+            }));
+            return streamed;
+        });
+    });
+
+    // Server-sent events for an account's new transactions. Served from the in-memory tail, so it
+    // stays on the io thread; Last-Event-ID (or ?lastEventId= for the first connect) resumes a stream.
+    CROW_ROUTE(app, "/api/accounts/<int>/transactions/stream")
+    ([](const crow::request& req, crow::response& res, int accountId) {
+        auto& feed = TransactionFeed::instance();
+        std::string lastEventId = req.get_header_value("Last-Event-ID");
+        if (lastEventId.empty() && req.url_params.get("lastEventId")) {
+            lastEventId = req.url_params.get("lastEventId");
+        }
+
+        uint64_t cursor = feed.head(accountId);
+        if (!lastEventId.empty()) {
+            char* end = nullptr;
+            const unsigned long long parsed = strtoull(lastEventId.c_str(), &end, 10);
+            if (end && *end == '\0') {
+                cursor = parsed;
+            }
         }
 
-        return crow::response(account.toJson());
+        res.add_header_block(eventStreamHeaders);
+        res.stream_events(feed.eventSource(accountId, cursor));
+        res.end();
     });
 
-    // Endpoint to transfer funds
-    CROW_ROUTE(app, "/api/transfer").methods("POST"_method)
-    ([](const crow::request& req) {
-        auto body = crow::json::load(req.body);
-        if (!body) {
-            return crow::response(400, "Invalid JSON.");
+    // Delta sync: what changed in an account after the client's cursor, from the in-memory change log
+    CROW_ROUTE(app, "/api/accounts/<int>/changes")
+    ([](const crow::request& req, int accountId) {
+        const char* since = req.url_params.get("since");
+        if (!since) {
+            return jsonResponse(AccountChangeLog::instance().delta(accountId, nullptr));
         }
 
-        string senderId = body["senderId"].s();
-        string recipientId = body["recipientId"].s();
-        double amount = body["amount"].d();
+        char* end = nullptr;
+        const uint64_t cursor = strtoull(since, &end, 10);
+        if (end == since || *end != '\0') {
+            return crow::response(400, "Invalid cursor.");
+        }
+        return jsonResponse(AccountChangeLog::instance().delta(accountId, &cursor));
+    });
 
-        if (isUserLockedOut(senderId)) {
-            return crow::response(403, "Sender is locked out.");
+    // Ledger and available balance from the hold ledger. An account's first read seeds its balance
+    // from the account's events; every later read is answered on the io thread.
+    CROW_ROUTE(app, "/api/accounts/<int>/balances")
+    ([&scheduler](const crow::request& req, crow::response& res, int accountId) {
+        const HoldLedger::Balances balances = HoldLedger::instance().balances(accountId);
+        if (balances.known) {
+            res = arenaJsonResponse(req.arena, 200, [&](auto& writer) { writeBalances(writer, accountId, balances); });
+            res.end();
+            return;
         }
+        scheduler.dispatch(req, res, [arena = req.arena, accountId] {
+            if (!seedHoldBalance(accountId)) {
+                return crow::response(404, "Account not found.");
+            }
+            const HoldLedger::Balances seeded = HoldLedger::instance().balances(accountId);
+            return arenaJsonResponse(arena, 200, [&](auto& writer) { writeBalances(writer, accountId, seeded); });
+        });
+    });
+
+    // Places a hold against the available balance; {"amount":25.0,"ttlSeconds":3600}
+    CROW_ROUTE(app, "/api/accounts/<int>/holds").methods("POST"_method)
+    ([&scheduler](const crow::request& req, crow::response& res, int accountId) {
+        scheduler.dispatch(req, res, [&req, accountId] {
+            HoldRequest hold;
+            if (!HoldRequest::parse(req.body, hold, req.arena) || Journal::toCents(hold.amount) <= 0 || hold.ttlSeconds < 0.0) {
+                return crow::response(400, "Invalid JSON.");
+            }
 
-        CheckingAccount sender(senderId);
-        CheckingAccount recipient(recipientId);
+            if (!seedHoldBalance(accountId)) {
+                return crow::response(404, "Account not found.");
+            }
+            auto& holds = HoldLedger::instance();
+            const auto ttl = hold.ttlSeconds > 0.0 ? std::chrono::seconds(std::llround(std::ceil(hold.ttlSeconds))) : HoldLedger::kDefaultTtl;
+            const uint64_t holdId = holds.place(accountId, hold.amount, ttl);
+            if (holdId == 0) {
+                return crow::response(409, "Insufficient available balance.");
+            }
+
+            // hold IDs use all 64 bits, more than a JavaScript number holds exactly
+            char holdText[24];
+            const int holdLength = snprintf(holdText, sizeof(holdText), "%llu", static_cast<unsigned long long>(holdId));
+            const double available = holds.balances(accountId).available;
+            return arenaJsonResponse(req.arena, 201, [&](auto& writer) {
+                writer.beginObject();
+                writer.key("holdID");
+                writer.value(std::string_view(holdText, holdLength));
+                writer.key("available");
+                writer.value(available);
+                writer.endObject();
+            });
+        });
+    });
 
-        if (!sender.loadFromDatabase(database) || !recipient.loadFromDatabase(database)) {
-            return crow::response(404, "Sender or recipient account not found.");
+    // Releases a hold without posting it
+    CROW_ROUTE(app, "/api/holds/<uint>").methods("DELETE"_method)
+    ([](uint64_t holdId) {
+        if (!HoldLedger::instance().release(holdId)) {
+            return crow::response(404, "Hold not found.");
         }
+        return crow::response(204);
+    });
+
+    // Posts a batch of holds; {"settlements":[{"holdID":"...","amount":25.0}, ...]}
+    CROW_ROUTE(app, "/api/holds/settle").methods("POST"_method)
+    ([&scheduler](const crow::request& req, crow::response& res) {
+        scheduler.dispatch(req, res, [&req] {
+            SettleRequest request;
+            if (!SettleRequest::parse(req.body, request, req.arena)) {
+                return crow::response(400, "Invalid JSON.");
+            }
 
-        if (!sender.withdraw(amount)) {
-            return crow::response(400, "Insufficient funds.");
+            std::vector<HoldLedger::Settlement> batch;
+            batch.reserve(request.settlements.size());
+            for (const auto& item : request.settlements) {
+                char* end = nullptr;
+                const uint64_t parsed = strtoull(item.holdID.c_str(), &end, 10);
+                if (item.holdID.empty() || *end != '\0') {
+                    return crow::response(400, "Invalid settlement.");
+                }
+                const double amount = item.amount;
+                // at least a cent and no more than the hold; settle() checks again as it posts, and
+                // reports a hold that has gone as not settled
+                const double held = HoldLedger::instance().heldAmount(parsed);
+                if (Journal::toCents(amount) <= 0 || (held > 0.0 && amount > held)) {
+                    return crow::response(400, "Invalid settlement amount.");
+                }
+                batch.push_back(HoldLedger::Settlement{ parsed, amount });
+            }
+
+            const auto postings = HoldLedger::instance().settle(batch);
+            return arenaJsonResponse(req.arena, 200, [&](auto& writer) {
+                writer.beginObject();
+                writer.key("postings");
+                writer.beginArray();
+                for (const auto& posting : postings) {
+                    char holdText[24];
+                    const int holdLength = snprintf(holdText, sizeof(holdText), "%llu", static_cast<unsigned long long>(posting.holdID));
+                    writer.beginObject();
+                    writer.key("holdID");
+                    writer.value(std::string_view(holdText, holdLength));
+                    writer.key("accountID");
+                    writer.value(posting.accountID);
+                    writer.key("settled");
+                    writer.value(posting.settled);
+                    writer.key("balanceAfter");
+                    writer.value(posting.balanceAfter);
+                    writer.endObject();
+                }
+                writer.endArray();
+                writer.endObject();
+            });
+        });
+    });
+
+    // Re-derives every balance from the double-entry journal and compares it with the projections
+    CROW_ROUTE(app, "/api/ledger/verify")
+    ([&scheduler](const crow::request& req, crow::response& res) {
+        scheduler.dispatch(req, res, [arena = req.arena] {
+            const Journal::VerifyResult result = Journal::instance().verify();
+
+            return arenaJsonResponse(arena, 200, [&](auto& writer) {
+                writer.beginObject();
+                writer.key("ok");
+                writer.value(result.ok);
+                writer.key("entries");
+                writer.value(static_cast<int64_t>(result.entries));
+                writer.key("legs");
+                writer.value(static_cast<int64_t>(result.legs));
+                writer.key("accounts");
+                writer.value(static_cast<int64_t>(result.accounts));
+                writer.key("unbalancedEntries");
+                writer.value(static_cast<int64_t>(result.unbalancedEntries));
+                writer.key("mismatches");
+                writer.beginArray();
+                for (const auto& mismatch : result.mismatches) {
+                    writer.beginObject();
+                    writer.key("accountID");
+                    writer.value(mismatch.accountID);
+                    writer.key("journal");
+                    writer.value(Journal::fromCents(mismatch.journalCents));
+                    writer.key("projection");
+                    writer.value(Journal::fromCents(mismatch.projectionCents));
+                    writer.endObject();
+                }
+                writer.endArray();
+                writer.key("seconds");
+                writer.value(result.seconds);
+                writer.endObject();
+            });
+        });
+    });
+
+    // Full transaction history export as CSV (default) or NDJSON. Pages are read on the scheduler
+    // and written as they arrive, so an export of any size holds at most two pages.
+    CROW_ROUTE(app, "/api/accounts/<int>/export")
+    ([&scheduler](const crow::request& req, crow::response& res, int accountId) {
+        const char* format = req.url_params.get("format");
+        TransactionExport::Format exportFormat;
+        if (!format || strcmp(format, "csv") == 0) {
+            exportFormat = TransactionExport::Format::Csv;
+            res.add_header_block(csvExportHeaders);
+        } else if (strcmp(format, "ndjson") == 0) {
+            exportFormat = TransactionExport::Format::Ndjson;
+            res.add_header_block(ndjsonExportHeaders);
+        } else {
+            res.code = 400;
+            res.write("Unknown export format.");
+            res.end();
+            return;
         }
 
-        recipient.deposit(amount);
+        res.stream_events(TransactionExport::source(accountId, exportFormat, Transaction::getTransactionsPage, scheduler));
+        res.end();
+    });
 
-        sender.saveToDatabase(database);
-        recipient.saveToDatabase(database);
+    // An account's statement for one month (YYYY-MM), rendered with the same compiled template as
+    // the overnight batch
+    static StatementGenerator statementGenerator;
+    CROW_ROUTE(app, "/api/accounts/<int>/statements/<string>")
+    ([&scheduler](const crow::request& req, crow::response& res, int accountId, string month) {
+        if (!StatementGenerator::validMonth(month)) {
+            res.code = 400;
+            res.write("Month must be YYYY-MM.");
+            res.end();
+            return;
+        }
+        scheduler.dispatch(req, res, [accountId, month] {
+            crow::response statement;
+            statementGenerator.render(accountId, month, Transaction::getTransactionsPage, statement.body);
+            statement.add_header_block(htmlHeaders);
+            return statement;
+        });
+    });
 
-        Transaction transaction(senderId, recipientId, amount, "Transfer");
-        transaction.saveToDatabase(database);
+    // Endpoint to transfer funds
+    CROW_ROUTE(app, "/api/transfer").methods("POST"_method)
+    ([&scheduler](const crow::request& req, crow::response& res) {
+        // the request outlives the handler: the connection waits for res.end() before reading the next one
+        scheduler.dispatch(req, res, [&req] {
+            TransferRequest transfer;
+            if (!TransferRequest::parse(req.body, transfer, req.arena)) {
+                return crow::response(400, "Invalid JSON.");
+            }
 
-        return crow::response(200, "Transfer successful.");
+            int senderId = 0;
+            int recipientId = 0;
+            if (!parseAccountId(transfer.senderId, senderId) || !parseAccountId(transfer.recipientId, recipientId) || senderId == recipientId) {
+                return crow::response(400, "Invalid sender or recipient.");
+            }
+            const double amount = transfer.amount;
+            if (Journal::toCents(amount) <= 0) {
+                return crow::response(400, "Amount must be positive.");
+            }
+
+            AccountEvents::State state;
+            if (!AccountEvents::instance().find(senderId, state) || !AccountEvents::instance().find(recipientId, state)) {
+                return crow::response(404, "Sender or recipient account not found.");
+            }
+            Account sender = Account::fetchAccount(senderId);
+            Account recipient = Account::fetchAccount(recipientId);
+            if (isUserLockedOut(std::to_string(sender.getUserID()))) {
+                return crow::response(403, "Sender is locked out.");
+            }
+
+            // taken before any money moves, since the first call reads Firestore and may throw
+            const int senderRowId = Transaction::nextTransactionID();
+            const int recipientRowId = Transaction::nextTransactionID();
+            if (!sender.transfer(recipient, amount)) {
+                return crow::response(400, "Insufficient funds.");
+            }
+            sender.publishBalance();
+            recipient.publishBalance();
+
+            // one row per side, with the signed amount and that side's balance after the transfer
+            const string date = Transaction::today();
+            const Transaction rows[] = {
+                Transaction(senderRowId, senderId, "transfer", -amount, date, sender.getBalance()),
+                Transaction(recipientRowId, recipientId, "transfer", amount, date, recipient.getBalance()),
+            };
+            bool saved = true;
+            for (const Transaction& row : rows) {
+                saved = row.publish() && saved;
+            }
+            if (!saved) {
+                return crow::response(500, "Transfer made, but its transaction record could not be saved.");
+            }
+            return crow::response(200, "Transfer successful.");
+        });
     });
 
+    // Real-time balance updates; clients send {"subscribe":<accountID>} for each account they show
+    CROW_ROUTE(app, "/ws/balances")
+        .websocket()
+        .onopen([](crow::websocket::connection& conn) {
+            BalanceFeed::instance().open(conn);
+        })
+        .onmessage([](crow::websocket::connection& conn, const string& data, bool isBinary) {
+            if (!isBinary) {
+                BalanceFeed::instance().message(conn, data);
+            }
+        })
+        .onclose([](crow::websocket::connection& conn, const string& /*reason*/) {
+            BalanceFeed::instance().close(conn);
+        });
+
     // Serve static files for the React frontend
     CROW_ROUTE(app, "/<path>")
-    ([](const crow::request& req, crow::response& res, std::string path) {
+    ([&scheduler](const crow::request& req, crow::response& res, std::string path) {
         if (path.empty()) {
             path = "index.html";
         }
-        std::ifstream file("../Frontend/" + path);
-        if (!file) {
-            res.code = 404;
-            res.end("File not found");
-            return;
-        }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        res.end(buffer.str());
+        scheduler.dispatch(req, res, [path] {
+            crow::response file;
+            if (!readFrontendFile(path, file.body)) {
+                return crow::response(404, "File not found");
+            }
+            return file;
+        });
     });
 
     // Serve the index.html file for the root path
     CROW_ROUTE(app, "/")
-    ([]() {
-        std::ifstream file("../Frontend/index.html");
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
+    ([&scheduler](const crow::request& req, crow::response& res) {
+        scheduler.dispatch(req, res, [] {
+            crow::response file;
+            readFrontendFile("index.html", file.body);
+            return file;
+        });
     });
 }
 
@@ -195,17 +634,53 @@ void linkRoutes(crow::SimpleApp& app) {
  * @returns int Exit code of the application.
  */
 int main() {
-    crow::SimpleApp app;
+    // Crow's log lines go through the asynchronous logger instead of blocking on stderr
+    static AsyncLogHandler logHandler;
+    crow::logger::setHandler(&logHandler);
+
+    BankingApp app;
+
+    // Balance changes also go to the delta-sync change log
+    BalanceFeed::instance().listen([](int accountID, double balance) {
+        AccountChangeLog::instance().recordBalance(accountID, balance);
+    });
+    // ...and to the hold ledger, which serves ledger and available balances from memory
+    BalanceFeed::instance().listen([](int accountID, double balance) {
+        HoldLedger::instance().setBalance(accountID, balance);
+    });
+
+    // Declared after the app so its workers stop before the io_services they post to go away
+    PriorityScheduler scheduler;
+    app.get_middleware<AdmissionControl>().watch(scheduler);
+
+    // Rebuild the account projections from the last snapshot and the events after it
+    AccountEvents::instance().load("data/accounts");
 
     // Initialize Firebase
     initializeFirebase();
 
+    // Reconcile the account projections against the stored transactions every night
+    NightlyReconciliation reconciliation(Transaction::getAllTransactionsPage, [] {
+        std::vector<Reconciler::StoredBalance> balances;
+        for (const AccountEvents::State& state : AccountEvents::instance().states()) {
+            balances.push_back(Reconciler::StoredBalance{ state.accountID, Journal::fromCents(state.balanceCents) });
+        }
+        return balances;
+    }, "data/reconciliation");
+
     // Link routes for API endpoints and static file serving
-    linkRoutes(app);
+    linkRoutes(app, scheduler);
 
     // Start the Crow server on port 5000
     cout << "Starting Crow server on http://localhost:5000" << endl;
     app.port(5000).multithreaded().run();
 
+    // the feeds post to the server's io_services, which go away with the app
+    BalanceFeed::instance().stop();
+    TransactionFeed::instance().stop();
+    HoldLedger::instance().stop();
+    reconciliation.stop();
+    AccountEvents::instance().stop();
+
     return 0;
 }